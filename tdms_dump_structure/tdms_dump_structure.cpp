@@ -6,12 +6,81 @@
  * @copyright MIT License
 **/
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <future>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <list>
 #include <sstream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
 #include <stack>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#define TDMS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(TDMS_MMAP)
+#define TDMS_SOCKET 1
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#endif
+
+#if defined(__linux__)
+#define TDMS_INOTIFY 1
+#include <sys/inotify.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TDMS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if LDBL_MANT_DIG == 64 && defined(TDMS_X86)
+#define TDMS_LONG_DOUBLE_IS_EXTENDED 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TDMS_TARGET(features) __attribute__((target(features)))
+#else
+#define TDMS_TARGET(features)
+#endif
 
 namespace {
 
@@ -33,13 +102,8 @@ namespace {
     char toc_unused[3];
   };
 
-  // layout of 80 bit extended floating point number
-  struct float80Struct_ {
-    unsigned long long mantissa : 64;
-    unsigned int exponent : 15;
-    bool sign : 1;
-  };
-
+  // 80 bit extended floating point number. Little endian it is stored as 64 bit mantissa
+  // with explicit integer bit followed by 15 bit exponent and sign bit.
   using float80_ = unsigned char[10];
   using fixpoint128_ = unsigned char[16];
 
@@ -143,6 +207,116 @@ namespace {
     }
   }
 
+  /**
+   * @brief Get the size in bytes of the parts of a value that need to be swapped separately
+   *        if the endianess of the file does not match the operating system
+   * 
+   * @param datatype Data type to determine swap size of
+   * @return size in bytes of the swap unit. Complex values consist of two numbers that are swapped
+   *         independently. Timestamps are swapped as a whole as the order of seconds and fraction
+   *         depends on the endianess. For string the size of the offsets is returned.
+   */
+  std::size_t get_tdms_data_type_swap_size(const tdmsDataType datatype)
+  {
+    switch (datatype) {
+    case tdmsTypeString: return sizeof(uint32_t);
+    case tdmsTypeComplexSingleFloat: return sizeof(float);
+    case tdmsTypeComplexDoubleFloat: return sizeof(double);
+    default: return get_tdms_data_type_byte_size(datatype);
+    }
+  }
+
+  /**
+   * @brief Convert the fields of an 80 bit extended floating point number to double with a
+   *        single rounding. The 64 bit mantissa is rounded by the integer conversion and the
+   *        exponent is rebiased in the bit pattern of the result. Only results in the subnormal
+   *        range of double take a separate path.
+   *
+   * @param mantissa      64 bit mantissa including the explicit integer bit
+   * @param signExponent  sign bit and 15 bit exponent with bias 16383
+   * @return nearest double. Out of range values result in infinity or signed zero.
+   */
+  inline double extended_float_to_double(const uint64_t mantissa, const uint16_t signExponent)
+  {
+    const uint64_t sign = uint64_t(signExponent >> 15) << 63;
+    const int64_t exponent = signExponent & 0x7FFF;
+    const double rounded = static_cast<double>(mantissa);
+    uint64_t roundedBits;
+    std::memcpy(&roundedBits, &rounded, sizeof(roundedBits));
+    // exponent of the integer mantissa is 63 higher than the value
+    const int64_t biased = int64_t(roundedBits >> 52) + exponent - 16383 - 63;
+
+    uint64_t bits;
+    if (biased <= 0 && 0 != mantissa && 0x7FFF != exponent) {
+      // subnormal result: round the mantissa directly to units of 2^-1074. A carry into the
+      // exponent field yields the smallest normal number as wanted.
+      const int64_t shift = 16383 + 63 - 1074 - exponent;
+      uint64_t units;
+      if (shift <= 0) {
+        units = mantissa << -shift;
+      }
+      else if (shift < 64) {
+        const uint64_t remainder = mantissa & ((uint64_t(1) << shift) - 1);
+        const uint64_t half = uint64_t(1) << (shift - 1);
+        units = mantissa >> shift;
+        units += (remainder > half || (remainder == half && (units & 1))) ? 1 : 0;
+      }
+      else {
+        units = (64 == shift && mantissa > (uint64_t(1) << 63)) ? 1 : 0;
+      }
+      bits = sign | units;
+    }
+    else {
+      const uint64_t infinity = sign | 0x7FF0000000000000ULL;
+      const uint64_t nan = infinity | 0x0008000000000000ULL | ((mantissa << 1) >> 12);
+      bits = sign | (uint64_t(biased) << 52) | (roundedBits & 0x000FFFFFFFFFFFFFULL);
+      bits = biased >= 0x7FF ? infinity : bits;
+      bits = 0 == mantissa ? sign : bits;
+      bits = 0x7FFF == exponent ? (0 == (mantissa << 1) ? infinity : nan) : bits;
+    }
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  /**
+   * @brief Seconds between the tdms epoch 1904-01-01 and the unix epoch 1970-01-01, both UTC
+   */
+  const int64_t tdms_epoch_to_unix_epoch_in_seconds = 2082844800;
+
+  /**
+   * @brief Convert a tdms timestamp to nanoseconds since the unix epoch. The fraction is rounded
+   *        to the nearest nanosecond using only 32x32 bit products:
+   *        round(fraction * 1e9 / 2^64) = (hi * 1e9 + ((lo * 1e9) >> 32) + 2^31) >> 32
+   *        with hi and lo being the upper and lower 32 bit of the fraction.
+   *
+   * @param seconds   seconds since 1904-01-01
+   * @param fraction  positive fractions of a second in units of 2^-64
+   * @return nanoseconds since 1970-01-01. Timestamps outside of about 1678 to 2262 wrap around.
+   */
+  inline int64_t timestamp_to_unix_nanoseconds(const int64_t seconds, const uint64_t fraction)
+  {
+    const uint64_t nanosecondsPerSecond = 1000000000;
+    const uint64_t fractionHigh = (fraction >> 32) * nanosecondsPerSecond;
+    const uint64_t fractionLow = (fraction & 0xFFFFFFFF) * nanosecondsPerSecond;
+    const uint64_t fractionNanoseconds = (fractionHigh + (fractionLow >> 32) + 0x80000000) >> 32;
+    return int64_t((uint64_t(seconds) - uint64_t(tdms_epoch_to_unix_epoch_in_seconds)) * nanosecondsPerSecond + fractionNanoseconds);
+  }
+
+  /**
+   * @brief Convert a tdms timestamp to seconds since the unix epoch. The fraction is first
+   *        truncated to its upper 53 bit, which drops less than 2^-53 seconds. Whole seconds and
+   *        the truncated fraction are exact doubles, their sum is rounded to nearest.
+   *
+   * @param seconds   seconds since 1904-01-01
+   * @param fraction  positive fractions of a second in units of 2^-64
+   * @return seconds since 1970-01-01
+   */
+  inline double timestamp_to_unix_seconds(const int64_t seconds, const uint64_t fraction)
+  {
+    return static_cast<double>(seconds - tdms_epoch_to_unix_epoch_in_seconds) + static_cast<double>(fraction >> 11) * 0x1p-53;
+  }
+
   /**
    * @brief class to do the file system access
    */
@@ -222,6 +396,117 @@ namespace {
     uint64_t size_{ 0 };
   };
 
+  /**
+   * @brief Map a file read only into memory. If mapping is not possible the whole file is read
+   *        in one bulk read instead.
+   */
+  class MappedFile
+  {
+  public:
+    /**
+     * @brief Map the file
+     * 
+     * @tparam PathType  std::string or std::wstring to allow utf16 usage on windows if needed
+     * @param filepath  path of the file
+     */
+    template<class PathType> explicit MappedFile(const PathType& filepath)
+    {
+      const std::filesystem::path path(filepath);
+#if defined(_WIN32)
+      file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (INVALID_HANDLE_VALUE == file_) {
+        throw std::logic_error("Failed to open file");
+      }
+      LARGE_INTEGER fileSize;
+      if (GetFileSizeEx(file_, &fileSize)) {
+        size_ = uint64_t(fileSize.QuadPart);
+      }
+      if (0 != size_) {
+        mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (nullptr != mapping_) {
+          data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        }
+      }
+#elif defined(TDMS_MMAP)
+      const int fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0) {
+        throw std::logic_error("Failed to open file");
+      }
+      struct stat fileStat;
+      if (0 == fstat(fd, &fileStat)) {
+        size_ = uint64_t(fileStat.st_size);
+      }
+      if (0 != size_) {
+        void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (MAP_FAILED != mapped) {
+          data_ = static_cast<const uint8_t*>(mapped);
+        }
+      }
+      close(fd);
+#endif
+      mapped_ = nullptr != data_;
+      if (!mapped_) {
+        FileIo fileIo(filepath);
+        size_ = fileIo.size();
+        buffer_.resize(size_);
+        if (0 != size_) {
+          fileIo.read_bytes(&buffer_[0], size_);
+        }
+        data_ = buffer_.data();
+      }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+#if defined(_WIN32)
+      if (mapped_) {
+        UnmapViewOfFile(data_);
+      }
+      if (nullptr != mapping_) {
+        CloseHandle(mapping_);
+      }
+      if (INVALID_HANDLE_VALUE != file_) {
+        CloseHandle(file_);
+      }
+#elif defined(TDMS_MMAP)
+      if (mapped_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+      }
+#endif
+    }
+
+    /**
+     * @brief Get the content of the file
+     */
+    const uint8_t* data() const
+    {
+      return data_;
+    }
+
+    /**
+     * @brief Get the size of the file
+     * 
+     * @return return file size in bytes
+     */
+    uint64_t size() const
+    {
+      return size_;
+    }
+
+  private:
+    const uint8_t* data_{ nullptr };
+    uint64_t size_{ 0 };
+    bool mapped_{ false };
+    std::vector<uint8_t> buffer_;
+#if defined(_WIN32)
+    HANDLE file_{ INVALID_HANDLE_VALUE };
+    HANDLE mapping_{ nullptr };
+#endif
+  };
+
   /**
    * @brief Wrapper for Segment reading to manage the swapping of endianess for numeric values
    */
@@ -267,14 +552,13 @@ namespace {
       fileIo_.read_bytes(&strVal[0], numberOfBytes);
     }
 
-  private:
     /**
      * @brief Determine if the operating system is big or little endian
      * 
      * @return true  if big endian system
      * @return false if little endian system
      */
-    bool is_big_endian_os()
+    static bool is_big_endian_os()
     {
       union {
         uint32_t i;
@@ -283,7 +567,8 @@ namespace {
       return int_union.c[0] == 1;
     }
 
-    inline void swap_endianess(uint8_t *buffer, const size_t &byteCount)
+  private:
+    static inline void swap_endianess(uint8_t *buffer, const size_t &byteCount)
     {
       const size_t swapCount(byteCount / 2);
       if (0 == swapCount) {
@@ -300,7 +585,7 @@ namespace {
     }
 
     template <typename T>
-    inline void swap_endianess(T &value)
+    static inline void swap_endianess(T &value)
     {
       swap_endianess(reinterpret_cast<uint8_t *>(&value), sizeof(T));
     }
@@ -310,6 +595,64 @@ namespace {
     const bool swapEndianess_;
   };
 
+  /**
+   * @brief Convert an extended floating point value read by SgmtFileIo::read_value to double
+   *
+   * @param value value in the byte order of the operating system
+   * @return nearest double
+   */
+  double extended_float_to_double(const float80_& value)
+  {
+    const bool bigEndianOs = SgmtFileIo::is_big_endian_os();
+    uint64_t mantissa{ 0 };
+    uint16_t signExponent{ 0 };
+    std::memcpy(&mantissa, value + (bigEndianOs ? 2 : 0), sizeof(mantissa));
+    std::memcpy(&signExponent, value + (bigEndianOs ? 0 : 8), sizeof(signExponent));
+    return extended_float_to_double(mantissa, signExponent);
+  }
+
+  /**
+   * @brief Map the data type code of a DAQmx scaler to the tdms data type
+   * 
+   * @param daqmxDataType data type code stored in a DAQmx scaler
+   * @return tdms data type. tdmsTypeVoid for unknown codes.
+   */
+  tdmsDataType get_daqmx_data_type(const uint32_t daqmxDataType)
+  {
+    switch (daqmxDataType) {
+    case 0: return tdmsTypeU8;
+    case 1: return tdmsTypeI8;
+    case 2: return tdmsTypeU16;
+    case 3: return tdmsTypeI16;
+    case 4: return tdmsTypeU32;
+    case 5: return tdmsTypeI32;
+    case 6: return tdmsTypeU64;
+    case 7: return tdmsTypeI64;
+    case 8: return tdmsTypeSingleFloat;
+    case 9: return tdmsTypeDoubleFloat;
+    case 0xFFFFFFFF: return tdmsTypeTimeStamp;
+    default: return tdmsTypeVoid;
+    }
+  }
+
+  /**
+   * @brief Location of the values of a DAQmx channel in the raw buffers of a segment. Each raw
+   *        buffer is a sequence of strides, the values are read at a fixed offset in each stride.
+   *        Digital line scalers read a single bit of a byte in each stride.
+   */
+  class DaqmxScaler
+  {
+  public:
+    uint32_t data_type_{ 0 };
+    uint32_t raw_buffer_index_{ 0 };
+    uint32_t byte_offset_within_stride_{ 0 };
+    // only used for digital line scalers
+    uint32_t bit_offset_within_byte_{ 0 };
+    uint32_t sample_format_bitmap_{ 0 };
+    uint32_t scale_id_{ 0 };
+    bool digital_line_{ false };
+  };
+
   /**
    * @brief stores information describing the raw setup of a channel in a segment
    */
@@ -341,19 +684,316 @@ namespace {
     {
     }
 
+    /**
+     * @brief Get the data type of the values of the channel. For DAQmx channels this is the
+     *        data type of the first scaler, U8 for digital lines.
+     */
+    tdmsDataType value_datatype() const
+    {
+      if (tdmsTypeDAQmxRawData == datatype_) {
+        if (daqmx_scalers_.empty()) {
+          return tdmsTypeVoid;
+        }
+        // digital lines are decoded to one byte per sample containing 0 or 1
+        return daqmx_scalers_.front().digital_line_ ? tdmsTypeU8 : get_daqmx_data_type(daqmx_scalers_.front().data_type_);
+      }
+      return datatype_;
+    }
+
+    /**
+     * @brief Size of the DAQmx raw data of one chunk. All raw buffers are stored one after the
+     *        other, each containing number_of_values_ strides.
+     */
+    uint64_t daqmx_chunk_size() const
+    {
+      uint64_t strideSize{ 0LL };
+      for (const auto width : daqmx_raw_data_widths_) {
+        strideSize += width;
+      }
+      return strideSize * number_of_values_;
+    }
+
   public:
     std::string objPath_;
     tdmsDataType datatype_{ tdmsTypeVoid };
     uint32_t dimension_{ 1 };
     uint64_t number_of_values_{ 0LL };
     uint64_t total_size_in_byte_{ 0LL };
+    // only used for DAQmx raw data
+    std::vector<DaqmxScaler> daqmx_scalers_;
+    std::vector<uint32_t> daqmx_raw_data_widths_;
   };
 
   /**
-   * @brief Vector to collect raw channel definitions contained in a segment 
+   * @brief Map to lookup raw channel definitions by object path
    */
   using ObjectRawInfos = std::map<std::string, SgmtObjectRawInfo>;
 
+  /**
+   * @brief Vector to collect raw channel definitions contained in a segment. The order matches
+   *        the order of the channels in the raw data.
+   */
+  using ObjectRawInfoList = std::vector<SgmtObjectRawInfo>;
+
+  /**
+   * @brief Replace the raw info of a channel already contained in the list or append it
+   * 
+   * @param objectRawInfoList list to be updated
+   * @param sgmtObjectRawInfo raw info of the channel
+   */
+  void set_object_raw_info(ObjectRawInfoList& objectRawInfoList, const SgmtObjectRawInfo& sgmtObjectRawInfo)
+  {
+    for (auto& objectRawInfo : objectRawInfoList) {
+      if (objectRawInfo.objPath_ == sgmtObjectRawInfo.objPath_) {
+        objectRawInfo = sgmtObjectRawInfo;
+        return;
+      }
+    }
+    objectRawInfoList.push_back(sgmtObjectRawInfo);
+  }
+
+  /**
+   * @brief Remove the raw info of a channel from the list if it is contained
+   * 
+   * @param objectRawInfoList list to be updated
+   * @param objPath           object path of the channel
+   */
+  void remove_object_raw_info(ObjectRawInfoList& objectRawInfoList, const std::string& objPath)
+  {
+    objectRawInfoList.erase(std::remove_if(objectRawInfoList.begin(), objectRawInfoList.end(),
+      [&objPath](const SgmtObjectRawInfo& objectRawInfo) { return objectRawInfo.objPath_ == objPath; }),
+      objectRawInfoList.end());
+  }
+
+  /**
+   * @brief Position of the raw data of a channel inside a chunk of a segment
+   */
+  class SgmtChannelLayout
+  {
+  public:
+    /**
+     * @brief Size of a single value of the channel in bytes. Zero for strings.
+     */
+    uint64_t value_size() const
+    {
+      return uint64_t(get_tdms_data_type_byte_size(rawInfo_.datatype_)) * rawInfo_.dimension_;
+    }
+
+  public:
+    SgmtObjectRawInfo rawInfo_;
+    // non interleaved: byte offset of the channel block in the chunk
+    // interleaved: byte offset of the channel value in a row
+    uint64_t offset_in_chunk_{ 0LL };
+    uint64_t size_in_chunk_{ 0LL };
+  };
+
+  /**
+   * @brief Raw data layout of a single segment
+   */
+  class SgmtLayout
+  {
+  public:
+    /**
+     * @brief Size of a row of values in interleaved segments
+     */
+    uint64_t row_size() const
+    {
+      uint64_t rowSize{ 0LL };
+      for (const auto& channel : channels_) {
+        rowSize += channel.value_size();
+      }
+      return rowSize;
+    }
+
+  public:
+    long index_{ 0 };
+    uint64_t absolute_offset_{ 0LL };
+    uint64_t raw_data_absolute_offset_{ 0LL };
+    uint64_t raw_data_absolute_end_{ 0LL };
+    uint64_t chunk_size_{ 0LL };
+    uint64_t number_of_chunks_{ 0LL };
+    bool interleaved_{ false };
+    bool big_endian_{ false };
+    bool daqmx_{ false };
+    std::vector<SgmtChannelLayout> channels_;
+  };
+
+  /**
+   * @brief Value of a property. Numeric and boolean values are kept as double, timestamps as
+   *        seconds since the unix epoch, complex values by their real part and strings as utf8.
+   *        Non string values are also kept exactly as they are stored in a segment written in
+   *        the byte order of the operating system.
+   */
+  class PropertyValue
+  {
+  public:
+    tdmsDataType datatype_{ tdmsTypeVoid };
+    double number_{ 0. };
+    std::string string_;
+    std::vector<uint8_t> raw_;
+  };
+
+  /**
+   * @brief Get the bytes of a plain value in the byte order of the operating system
+   */
+  template<class T> std::vector<uint8_t> get_value_bytes(const T& value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "only plain values can be copied");
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    return std::vector<uint8_t>(bytes, bytes + sizeof(T));
+  }
+
+  /**
+   * @brief Properties of an object by name
+   */
+  using ObjectProperties = std::map<std::string, PropertyValue>;
+
+  /**
+   * @brief State of the meta data parser needed to continue parsing at a segment
+   */
+  class TdmsParseState
+  {
+  public:
+    int64_t segment_absolute_offset_{ 0LL };
+    long segment_index_{ 0 };
+    ObjectRawInfos object_raw_infos_all_;
+    ObjectRawInfoList object_raw_infos_curr_;
+  };
+
+  /**
+   * @brief Segment table of a TDMS file describing where the raw data of each channel is stored
+   */
+  class TdmsFileLayout
+  {
+  public:
+    /**
+     * @brief Get the paths of all channels containing raw data in order of appearance
+     */
+    std::vector<std::string> channel_paths() const
+    {
+      std::vector<std::string> channelPaths;
+      for (const auto& segment : segments_) {
+        for (const auto& channel : segment.channels_) {
+          if (channelPaths.end() == std::find(channelPaths.begin(), channelPaths.end(), channel.rawInfo_.objPath_)) {
+            channelPaths.push_back(channel.rawInfo_.objPath_);
+          }
+        }
+      }
+      return channelPaths;
+    }
+
+    /**
+     * @brief Find the first occurrence of a channel
+     * 
+     * @param channelPath object path of the channel
+     * @return layout of the channel in the first segment containing it or nullptr
+     */
+    const SgmtChannelLayout* find_channel(const std::string& channelPath) const
+    {
+      for (const auto& segment : segments_) {
+        for (const auto& channel : segment.channels_) {
+          if (channel.rawInfo_.objPath_ == channelPath) {
+            return &channel;
+          }
+        }
+      }
+      return nullptr;
+    }
+
+    /**
+     * @brief Find the properties of an object
+     * 
+     * @param objPath  object path like /'group'/'channel'
+     * @return latest values of the properties of the object or nullptr
+     */
+    const ObjectProperties* find_properties(const std::string& objPath) const
+    {
+      const auto properties = properties_.find(objPath);
+      return properties_.end() == properties ? nullptr : &properties->second;
+    }
+
+    /**
+     * @brief Find a property of an object
+     * 
+     * @param objPath  object path like /'group'/'channel'
+     * @param name     name of the property
+     * @return latest value of the property or nullptr
+     */
+    const PropertyValue* find_property(const std::string& objPath, const std::string& name) const
+    {
+      const ObjectProperties* properties = find_properties(objPath);
+      if (nullptr == properties) {
+        return nullptr;
+      }
+      const auto property = properties->find(name);
+      return properties->end() == property ? nullptr : &property->second;
+    }
+
+    /**
+     * @brief Get a FNV-1a hash over the file size and the position and raw data layout of all
+     *        segments. Sidecar files store it to detect that they do not match the file anymore.
+     */
+    uint64_t segment_table_key() const
+    {
+      uint64_t key = 0xcbf29ce484222325ULL;
+      const auto add = [&key](const uint64_t value) {
+        for (int byteIndex = 0; byteIndex < 8; ++byteIndex) {
+          key = (key ^ ((value >> (8 * byteIndex)) & 0xFF)) * 0x100000001b3ULL;
+        }
+      };
+      add(size_);
+      for (const auto& segment : segments_) {
+        add(segment.absolute_offset_);
+        add(segment.raw_data_absolute_offset_);
+        add(segment.raw_data_absolute_end_);
+        add(segment.chunk_size_);
+        add(segment.number_of_chunks_);
+      }
+      return key;
+    }
+
+  public:
+    uint64_t size_{ 0LL };
+    std::vector<SgmtLayout> segments_;
+    // latest property values of each object path
+    std::map<std::string, ObjectProperties> properties_;
+    // where to continue parsing if the file grows. Segments still being written are parsed again.
+    TdmsParseState parse_state_;
+  };
+
+  /**
+   * @brief Content hashes of a single segment
+   */
+  class SgmtHashes
+  {
+  public:
+    // lead in and meta data
+    uint64_t meta_data_{ 0LL };
+    uint64_t raw_data_{ 0LL };
+    // index of the first earlier segment with identical content or -1
+    long duplicate_of_{ -1 };
+  };
+
+  /**
+   * @brief Content hashes of all segments and the tree hash of the file combining them
+   */
+  class FileHashes
+  {
+  public:
+    std::vector<SgmtHashes> segments_;
+    uint64_t tree_{ 0LL };
+  };
+
+  /**
+   * @brief Format a hash as fixed width hexadecimal number
+   */
+  std::string format_hash(const uint64_t hash)
+  {
+    std::ostringstream ost;
+    ost << "0x" << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return ost.str();
+  }
+
   /**
    * @brief Simple logger to collect information found in TDMS file while parsing
    */
@@ -367,12 +1007,24 @@ namespace {
        * @param filepath path to the xml file to be written
        */
       template<class T> ContentLoggerXml(const T& filepath) :
-        ost_(filepath, std::ios::binary | std::ios::out | std::ios::trunc)
+        file_(filepath, std::ios::binary | std::ios::out | std::ios::trunc), ost_(file_)
       {
         ost_.imbue(std::locale("C")); // make sure decimal point is dot
         ost_ << R"(<?xml version="1.0" encoding="UTF-8" standalone="no" ?>)" << std::endl;
       }
 
+      /**
+       * @brief Construct a logger writing an xml fragment without header into a stream
+       * 
+       * @param ost    stream to write to
+       * @param depth  number of tags enclosing the fragment
+       */
+      ContentLoggerXml(std::ostream& ost, const size_t depth) :
+        ost_(ost), depth_(depth)
+      {
+        ost_.imbue(std::locale("C")); // make sure decimal point is dot
+      }
+
       /**
        * @brief push a tag. Must be matched with an call to 'pop'
        * 
@@ -431,7 +1083,7 @@ namespace {
 
       void ident()
       {
-        for(auto i = open_.size(); i > 0; --i) {
+        for(auto i = open_.size() + depth_; i > 0; --i) {
           ost_ << "  ";
         }
       }
@@ -452,18 +1104,127 @@ namespace {
       }
 
     private:
-      std::ofstream ost_;
+      std::ofstream file_;
+      std::ostream& ost_;
+      size_t depth_{ 0 };
       std::stack<std::string> open_; 
   };
 
   /**
-   * @brief dump the structure of a tdms file into a structure logger
-   * 
+   * @brief Logger dropping all information. Used if only the layout of a file is of interest.
+   */
+  class ContentLoggerNull
+  {
+    public:
+      void push(const char*) {}
+      template<class T> void add(const char*, const T&) {}
+      void pop() {}
+  };
+
+  /**
+   * @brief Get the path of the index file NI writers store next to a tdms file
+   * 
+   * @param tdmsFilePath  path of the tdms file
+   * @return path of the tdms file with suffix _index
+   */
+  template<class PathType> std::filesystem::path get_tdms_index_file_path(const PathType& tdmsFilePath)
+  {
+    std::filesystem::path indexFilePath(tdmsFilePath);
+    indexFilePath += "_index";
+    return indexFilePath;
+  }
+
+  /**
+   * @brief Decode an unsigned integer of a lead in
+   * 
+   * @param bytes      stored value
+   * @param size       size of the value in bytes
+   * @param bigEndian  segment is stored big endian
+   */
+  uint64_t decode_lead_in_value(const uint8_t* bytes, const size_t size, const bool bigEndian)
+  {
+    uint64_t value{ 0 };
+    for (size_t byteIndex = 0; byteIndex < size; ++byteIndex) {
+      value |= uint64_t(bytes[bigEndian ? size - 1 - byteIndex : byteIndex]) << (8 * byteIndex);
+    }
+    return value;
+  }
+
+  /**
+   * @brief Check if an index file describes a tdms file. The index file repeats the lead in and
+   *        meta data of each segment tagged with TDSh instead of TDSm. Its segments have to end
+   *        exactly at the end of the tdms file and the lead ins of the first and last segment have
+   *        to match the tdms file. Only the lead ins of the index file and two lead ins of the tdms
+   *        file are read.
+   * 
+   * @param indexIo  index file
+   * @param dataIo   tdms file
+   * @return true if the meta data can be read from the index file
+   */
+  bool is_tdms_index_file_consistent(FileIo& indexIo, FileIo& dataIo)
+  {
+    constexpr size_t leadInSizeInByte{ sizeof(SgmtHeader) + sizeof(uint32_t) + 2 * sizeof(uint64_t) };
+    const auto matches_data_file = [&](const uint64_t dataOffset, const uint8_t* indexLeadIn) {
+      uint8_t dataLeadIn[leadInSizeInByte];
+      dataIo.seek(dataOffset);
+      return dataIo.read_no_throw(dataLeadIn, leadInSizeInByte) && 0 == std::memcmp(dataLeadIn, "TDSm", 4) &&
+        0 == std::memcmp(dataLeadIn + 4, indexLeadIn + 4, leadInSizeInByte - 4);
+    };
+
+    const uint64_t indexSize = indexIo.size();
+    const uint64_t dataSize = dataIo.size();
+    uint64_t indexOffset{ 0 };
+    uint64_t dataOffset{ 0 };
+    uint8_t leadIn[leadInSizeInByte];
+    while (indexOffset < indexSize) {
+      indexIo.seek(indexOffset);
+      if (!indexIo.read_no_throw(leadIn, leadInSizeInByte) || 0 != std::memcmp(leadIn, "TDSh", 4)) {
+        return false;
+      }
+      SgmtHeader sgmtHeader;
+      std::memcpy(&sgmtHeader, leadIn, sizeof(SgmtHeader));
+      const bool bigEndian = sgmtHeader.toc.BigEndian;
+      const uint64_t nextSegmentOffset = decode_lead_in_value(leadIn + 12, 8, bigEndian);
+      const uint64_t rawDataOffset = decode_lead_in_value(leadIn + 20, 8, bigEndian);
+      if (0x1269 != decode_lead_in_value(leadIn + 8, 4, bigEndian) || (0xFFFFFFFFFFFFFFFFULL != nextSegmentOffset && rawDataOffset > nextSegmentOffset)) {
+        return false;
+      }
+      if (0 == indexOffset && !matches_data_file(0, leadIn)) {
+        return false;
+      }
+      indexOffset += leadInSizeInByte + rawDataOffset;
+      if (indexOffset == indexSize && !matches_data_file(dataOffset, leadIn)) {
+        return false;
+      }
+      if (0xFFFFFFFFFFFFFFFFULL == nextSegmentOffset) {
+        // segment written without finalizing the lead in reaches up to the end of the file
+        if (indexOffset != indexSize) {
+          return false;
+        }
+        dataOffset = dataSize;
+      }
+      else {
+        dataOffset += leadInSizeInByte + nextSegmentOffset;
+      }
+    }
+    return indexOffset == indexSize && dataOffset == dataSize && 0 != indexSize;
+  }
+
+  /**
+   * @brief dump the structure of a tdms file into a structure logger. If a consistent index
+   *        file exists the meta data is read from it instead of seeking through the tdms file.
+   * 
    * @tparam PathType     std::string or std::wstring to support utf8 and utf16
+   * @tparam Logger       ContentLoggerXml or ContentLoggerNull
    * @param tdmsFilePath  path of the tdms file
    * @param sl            logger to write a target file
+   * @param layout        if not null it is filled with the raw data layout of all segments. If it
+   *                      already contains segments parsing continues at its parse state.
+   * @param hashes        if not null the content hashes are logged with each segment
+   * @param useIndexFile  use the index file next to the tdms file if it exists
    */
-  template<class PathType> void log_tdms_file_structure(const PathType& tdmsFilePath, ContentLoggerXml& sl)
+  template<class PathType, class Logger> void log_tdms_file_structure(const PathType& tdmsFilePath, Logger& sl, TdmsFileLayout* layout = nullptr,
+    const FileHashes* hashes = nullptr, const bool useIndexFile = true)
   {
     static_assert(1 == sizeof(bool), "bool is stored in byte");
     static_assert(10 == sizeof(float80_), "extended float needs 80bit");
@@ -477,15 +1238,61 @@ namespace {
     const int64_t fileSize = fileIo.size();
 
     sl.add("size_in_byte", fileSize);
+
+    // a layout read before the file grew is continued
+    const bool resume = nullptr != layout && !layout->segments_.empty();
+    std::unique_ptr<FileIo> indexIo;
+    if (useIndexFile && !resume) {
+      const std::filesystem::path indexFilePath = get_tdms_index_file_path(tdmsFilePath);
+      std::error_code errorCode;
+      if (std::filesystem::is_regular_file(indexFilePath, errorCode)) {
+        try {
+          indexIo.reset(new FileIo(indexFilePath));
+          if (is_tdms_index_file_consistent(*indexIo, fileIo)) {
+            sl.add("index_filepath", indexFilePath.u8string());
+          }
+          else {
+            indexIo.reset();
+          }
+        }
+        catch (const std::exception&) {
+          // fall back to the tdms file
+          indexIo.reset();
+        }
+      }
+    }
+    // lead ins and meta data are read from the index file if available
+    FileIo& metaDataIo = indexIo ? *indexIo : fileIo;
+    const char segmentTag = indexIo ? 'h' : 'm';
+
     sl.push("segments");
 
+    if (nullptr != layout) {
+      layout->size_ = fileSize;
+      if (!resume) {
+        layout->segments_.clear();
+        layout->properties_.clear();
+      }
+    }
+
     ObjectRawInfos objectRawInfosAll; // collects all to lookup for "0x0 == raw_data_index"
-    ObjectRawInfos objectRawInfosCurr; // will be resetted if new_obj_list is started
+    ObjectRawInfoList objectRawInfosCurr; // will be resetted if new_obj_list is started
     
     long sgmtIndex{ 0 };
     int64_t next_segment_absolute_offset{ 0LL };
+    int64_t next_index_offset{ 0LL };
+    if (resume) {
+      TdmsParseState& parseState = layout->parse_state_;
+      layout->segments_.resize(size_t(parseState.segment_index_));
+      sgmtIndex = parseState.segment_index_;
+      next_segment_absolute_offset = parseState.segment_absolute_offset_;
+      objectRawInfosAll = std::move(parseState.object_raw_infos_all_);
+      objectRawInfosCurr = std::move(parseState.object_raw_infos_curr_);
+    }
+    bool segmentStillWritten{ false };
     for (;;++sgmtIndex) {
       const int64_t curr_segment_absolute_offset{ next_segment_absolute_offset };
+      const int64_t curr_index_offset{ next_index_offset };
 
       if (fileSize == curr_segment_absolute_offset) {
         break;
@@ -493,20 +1300,20 @@ namespace {
 
       ///////////////////////////////////////////
       // read lead in
-      fileIo.seek(curr_segment_absolute_offset);
+      metaDataIo.seek(indexIo ? curr_index_offset : curr_segment_absolute_offset);
       SgmtHeader sgmtHeader;
-      if (!fileIo.read_no_throw(&sgmtHeader, sizeof(SgmtHeader))) {
+      if (!metaDataIo.read_no_throw(&sgmtHeader, sizeof(SgmtHeader))) {
         // No segment left
         break;
       }
-      if ('T' != sgmtHeader.tag[0] || 'D' != sgmtHeader.tag[1] || 'S' != sgmtHeader.tag[2] || 'm' != sgmtHeader.tag[3]) {
-        throw std::logic_error("Segment always starts with TDSm");
+      if ('T' != sgmtHeader.tag[0] || 'D' != sgmtHeader.tag[1] || 'S' != sgmtHeader.tag[2] || segmentTag != sgmtHeader.tag[3]) {
+        throw std::logic_error(indexIo ? "Index segment always starts with TDSh" : "Segment always starts with TDSm");
       }
       
       sl.push("segment");
       sl.add("index", sgmtIndex);
     
-      SgmtFileIo sgmtFileIO(fileIo, sgmtHeader.toc.BigEndian);
+      SgmtFileIo sgmtFileIO(metaDataIo, sgmtHeader.toc.BigEndian);
 
       uint32_t tdms_version;
       sgmtFileIO.read_value(tdms_version);
@@ -536,8 +1343,15 @@ namespace {
 
       const size_t leadInSizeInByte{ sizeof(SgmtHeader) + sizeof(tdms_version) + sizeof(next_segment_offset) + sizeof(raw_data_offset) };
 
+      if (nullptr != layout && 0xFFFFFFFFFFFFFFFFULL == next_segment_offset) {
+        // the writer did not finish the segment, so it has to be parsed again once the file grew
+        layout->parse_state_ = TdmsParseState{ curr_segment_absolute_offset, sgmtIndex, objectRawInfosAll, objectRawInfosCurr };
+        segmentStillWritten = true;
+      }
+
       // segment starts after lead in
       int64_t sgmtStartOffset = curr_segment_absolute_offset + leadInSizeInByte;
+      next_index_offset = curr_index_offset + leadInSizeInByte + raw_data_offset;
       if (0xFFFFFFFFFFFFFFFFLL == next_segment_offset) {
         next_segment_offset = fileSize - sgmtStartOffset;
       }
@@ -546,11 +1360,33 @@ namespace {
       sl.add("absolut_segment_offset", curr_segment_absolute_offset);
       sl.add("absolut_raw_data_offset", raw_data_absolute_offset_in_byte);
       sl.add("absolut_next_segment_byte_offset", next_segment_absolute_offset);
+      if (nullptr != hashes && size_t(sgmtIndex) < hashes->segments_.size()) {
+        const SgmtHashes& sgmtHashes = hashes->segments_[sgmtIndex];
+        sl.push("hashes");
+        sl.add("meta_data", format_hash(sgmtHashes.meta_data_));
+        sl.add("raw_data", format_hash(sgmtHashes.raw_data_));
+        if (0 <= sgmtHashes.duplicate_of_) {
+          sl.add("duplicate_of_segment", sgmtHashes.duplicate_of_);
+        }
+        sl.pop();
+      }
 
       if (sgmtHeader.toc.NewObjList) {
         objectRawInfosCurr.clear();
       }
 
+      if (nullptr != layout) {
+        SgmtLayout sgmtLayout;
+        sgmtLayout.index_ = sgmtIndex;
+        sgmtLayout.absolute_offset_ = curr_segment_absolute_offset;
+        sgmtLayout.raw_data_absolute_offset_ = raw_data_absolute_offset_in_byte;
+        sgmtLayout.raw_data_absolute_end_ = next_segment_absolute_offset;
+        sgmtLayout.interleaved_ = sgmtHeader.toc.InterleavedData;
+        sgmtLayout.big_endian_ = sgmtHeader.toc.BigEndian;
+        sgmtLayout.daqmx_ = sgmtHeader.toc.DAQmxRawData;
+        layout->segments_.push_back(sgmtLayout);
+      }
+
       // If the segment contains no meta data at all (properties, index information, object list), this value will be 0
       if(raw_data_offset > 0) {
 
@@ -570,7 +1406,8 @@ namespace {
           sl.add("raw_data_index", rawDataIndex);
 
           if (0xFFFFFFFF == rawDataIndex) {
-            // no raw data
+            // no raw data in this segment
+            remove_object_raw_info(objectRawInfosCurr, objPath);
           }
           else if (0x0 == rawDataIndex) {
             // raw setting of last segment
@@ -578,7 +1415,7 @@ namespace {
             if (objectRawInfosAll.end() == previousObjRawInfo) {
               throw std::logic_error("There is no raw info for this channel in the previous segment");
             }
-            objectRawInfosCurr[objPath] = previousObjRawInfo->second;
+            set_object_raw_info(objectRawInfosCurr, previousObjRawInfo->second);
           }
           else if (0x14 == rawDataIndex || 0x1c == rawDataIndex) {
             // normal raw data
@@ -606,7 +1443,7 @@ namespace {
 
             // rember the raw element definition
             SgmtObjectRawInfo sgmtObjectRawInfo(objPath, rawDatatypeEnum, rawDataArrayDimension, rawDataNumberOfValues, totalSizeInByte);
-            objectRawInfosCurr[objPath] = sgmtObjectRawInfo;
+            set_object_raw_info(objectRawInfosCurr, sgmtObjectRawInfo);
             objectRawInfosAll[objPath] = sgmtObjectRawInfo;
 
             sl.pop();
@@ -636,34 +1473,62 @@ namespace {
             sgmtFileIO.read_value(daqmxChunkSize); // Number of values
             sl.add("chunk_size", daqmxChunkSize);
 
+            SgmtObjectRawInfo sgmtObjectRawInfo(objPath, tdmsTypeDAQmxRawData, daqmxArrayDimension, daqmxChunkSize, 0);
+
             uint32_t daqmxFormatChangingScalersSize{ 0 };
             sgmtFileIO.read_value(daqmxFormatChangingScalersSize);
             sl.add("format_changing_scalers_size", daqmxFormatChangingScalersSize);
             sl.push("format_changing_scalers");
             for (uint32_t daqmxFormatChangingScalersIndex = 0UL; daqmxFormatChangingScalersIndex < daqmxFormatChangingScalersSize; ++daqmxFormatChangingScalersIndex) {
-              sl.push("format_changing_scaler");
+              const bool digitalLine = 0x1369 == rawDataIndex;
+              sl.push(digitalLine ? "digital_line_scaler" : "format_changing_scaler");
               uint32_t daqmxDataType{ 0 };
               sgmtFileIO.read_value(daqmxDataType);
-              const tdmsDataType daqmxDataTypeEnum = (tdmsDataType)daqmxDataType;
               sl.add("data_type", daqmxDataType);
-              sl.add("data_type_string", get_tdms_data_type_as_string(daqmxDataTypeEnum));
+              sl.add("data_type_string", get_tdms_data_type_as_string(get_daqmx_data_type(daqmxDataType)));
 
               uint32_t daqmxRawBufferIndex{ 0 };
               sgmtFileIO.read_value(daqmxRawBufferIndex);
               sl.add("buffer_index", daqmxRawBufferIndex);
 
-              uint32_t daqmxRawByteOffsetWithinTheStride{ 0 };
-              sgmtFileIO.read_value(daqmxRawByteOffsetWithinTheStride);
-              sl.add("byte_offset_within_the_stride", daqmxRawByteOffsetWithinTheStride);
+              DaqmxScaler daqmxScaler;
+              if (digitalLine) {
+                // digital line scalers address a single bit and store the bitmap in a single byte
+                uint32_t daqmxRawBitOffsetWithinTheStride{ 0 };
+                sgmtFileIO.read_value(daqmxRawBitOffsetWithinTheStride);
+                sl.add("bit_offset_within_the_stride", daqmxRawBitOffsetWithinTheStride);
+
+                uint8_t daqmxSampleFormatBitmap{ 0 };
+                sgmtFileIO.read_value(daqmxSampleFormatBitmap);
+                sl.add("sample_format_bitmap", uint32_t(daqmxSampleFormatBitmap));
 
-              uint32_t daqmxSampleFormatBitmap{ 0 };
-              sgmtFileIO.read_value(daqmxSampleFormatBitmap);
-              sl.add("sample_format_bitmap", daqmxSampleFormatBitmap);
+                daqmxScaler.byte_offset_within_stride_ = daqmxRawBitOffsetWithinTheStride / 8;
+                daqmxScaler.bit_offset_within_byte_ = daqmxRawBitOffsetWithinTheStride % 8;
+                daqmxScaler.sample_format_bitmap_ = daqmxSampleFormatBitmap;
+              }
+              else {
+                uint32_t daqmxRawByteOffsetWithinTheStride{ 0 };
+                sgmtFileIO.read_value(daqmxRawByteOffsetWithinTheStride);
+                sl.add("byte_offset_within_the_stride", daqmxRawByteOffsetWithinTheStride);
+
+                uint32_t daqmxSampleFormatBitmap{ 0 };
+                sgmtFileIO.read_value(daqmxSampleFormatBitmap);
+                sl.add("sample_format_bitmap", daqmxSampleFormatBitmap);
+
+                daqmxScaler.byte_offset_within_stride_ = daqmxRawByteOffsetWithinTheStride;
+                daqmxScaler.sample_format_bitmap_ = daqmxSampleFormatBitmap;
+              }
 
               uint32_t daqmxScaleID{ 0 };
               sgmtFileIO.read_value(daqmxScaleID);
               sl.add("scale_id", daqmxScaleID);
               sl.pop();
+
+              daqmxScaler.data_type_ = daqmxDataType;
+              daqmxScaler.raw_buffer_index_ = daqmxRawBufferIndex;
+              daqmxScaler.scale_id_ = daqmxScaleID;
+              daqmxScaler.digital_line_ = digitalLine;
+              sgmtObjectRawInfo.daqmx_scalers_.push_back(daqmxScaler);
             }
             sl.pop();
 
@@ -675,9 +1540,14 @@ namespace {
               uint32_t daqmxElementsInTheVector{ 0 };
               sgmtFileIO.read_value(daqmxElementsInTheVector);
               sl.add("size", daqmxElementsInTheVector);
+              sgmtObjectRawInfo.daqmx_raw_data_widths_.push_back(daqmxElementsInTheVector);
             }
             sl.pop();
             sl.pop();
+
+            // rember the raw element definition
+            set_object_raw_info(objectRawInfosCurr, sgmtObjectRawInfo);
+            objectRawInfosAll[objPath] = sgmtObjectRawInfo;
           }
           else {
             throw std::logic_error("mode not supported: unknown");
@@ -696,6 +1566,8 @@ namespace {
             uint32_t propDataType{ 0 };
             sgmtFileIO.read_value(propDataType);
             tdmsDataType propDatatypeEnum = (tdmsDataType)propDataType;
+            PropertyValue propValue;
+            propValue.datatype_ = propDatatypeEnum;
 
             sl.add("data_type", propDataType);
             sl.add("data_type_string", get_tdms_data_type_as_string(propDatatypeEnum));
@@ -708,56 +1580,78 @@ namespace {
               int8_t propVal{ 0 };
               sgmtFileIO.read_value(propVal);
               sl.add("value", propVal);
+              propValue.number_ = double(propVal);
+              propValue.raw_ = get_value_bytes(propVal);
             }break;
             case tdmsTypeI16: {
               int16_t propVal{ 0 };
               sgmtFileIO.read_value(propVal);
               sl.add("value", propVal);
+              propValue.number_ = double(propVal);
+              propValue.raw_ = get_value_bytes(propVal);
             }break;
             case tdmsTypeI32: {
               int32_t propVal{ 0 };
               sgmtFileIO.read_value(propVal);
               sl.add("value", propVal);
+              propValue.number_ = double(propVal);
+              propValue.raw_ = get_value_bytes(propVal);
             }break;
             case tdmsTypeI64: {
               int64_t propVal{ 0 };
               sgmtFileIO.read_value(propVal);
               sl.add("value", propVal);
+              propValue.number_ = double(propVal);
+              propValue.raw_ = get_value_bytes(propVal);
             }break;
             case tdmsTypeU8: {
               uint8_t propVal{ 0 };
               sgmtFileIO.read_value(propVal);
               sl.add("value", propVal);
+              propValue.number_ = double(propVal);
+              propValue.raw_ = get_value_bytes(propVal);
             }break;
             case tdmsTypeU16: {
               uint16_t propVal{ 0 };
               sgmtFileIO.read_value(propVal);
               sl.add("value", propVal);
+              propValue.number_ = double(propVal);
+              propValue.raw_ = get_value_bytes(propVal);
             }break;
             case tdmsTypeU32: {
               uint32_t propVal{ 0 };
               sgmtFileIO.read_value(propVal);
               sl.add("value", propVal);
+              propValue.number_ = double(propVal);
+              propValue.raw_ = get_value_bytes(propVal);
             }break;
             case tdmsTypeU64: {
               uint64_t propVal{ 0 };
               sgmtFileIO.read_value(propVal);
               sl.add("value", propVal);
+              propValue.number_ = double(propVal);
+              propValue.raw_ = get_value_bytes(propVal);
             }break;
             case tdmsTypeSingleFloat: {
               float propVal{ 0 };
               sgmtFileIO.read_value(propVal);
               sl.add("value", propVal);
+              propValue.number_ = double(propVal);
+              propValue.raw_ = get_value_bytes(propVal);
             }break;
             case tdmsTypeDoubleFloat: {
               double propVal{ 0 };
               sgmtFileIO.read_value(propVal);
               sl.add("value", propVal);
+              propValue.number_ = double(propVal);
+              propValue.raw_ = get_value_bytes(propVal);
             }break;
             case tdmsTypeExtendedFloat: {
               float80_ propVal;
               sgmtFileIO.read_value(propVal);
-              sl.add("value", propVal);
+              sl.add("value", extended_float_to_double(propVal));
+              propValue.number_ = extended_float_to_double(propVal);
+              propValue.raw_ = get_value_bytes(propVal);
             }break;
             case tdmsTypeSingleFloatWithUnit: {
               throw std::logic_error("with unit not allowed for property");
@@ -773,22 +1667,37 @@ namespace {
               std::string propVal;
               sgmtFileIO.read_string(propVal);
               sl.add("value", propVal);
+              propValue.string_ = propVal;
             }break;
             case tdmsTypeBoolean: {
               uint8_t propVal;
               sgmtFileIO.read_value(propVal);
               bool boolVal{ propVal != 0 };
               sl.add("value", propVal);
+              propValue.number_ = boolVal ? 1. : 0.;
+              propValue.raw_ = get_value_bytes(propVal);
             }break;
             case tdmsTypeTimeStamp: {
+              // little endian the fraction is stored first
               int64_t propValSec{ 0LL };
-              sgmtFileIO.read_value(propValSec);
               uint64_t propValFrac{ 0LL };
-              sgmtFileIO.read_value(propValFrac);
+              if (sgmtHeader.toc.BigEndian) {
+                sgmtFileIO.read_value(propValSec);
+                sgmtFileIO.read_value(propValFrac);
+              }
+              else {
+                sgmtFileIO.read_value(propValFrac);
+                sgmtFileIO.read_value(propValSec);
+              }
               sl.push("value");
               sl.add("seconds", propValSec);
               sl.add("fraction", propValFrac);
+              sl.add("unix_nanoseconds", timestamp_to_unix_nanoseconds(propValSec, propValFrac));
               sl.pop();
+              propValue.number_ = timestamp_to_unix_seconds(propValSec, propValFrac);
+              const uint64_t seconds = uint64_t(propValSec);
+              propValue.raw_ = get_value_bytes(SgmtFileIo::is_big_endian_os() ?
+                std::array<uint64_t, 2>{ seconds, propValFrac } : std::array<uint64_t, 2>{ propValFrac, seconds });
             }break;
             case tdmsTypeFixedPoint: {
               fixpoint128_ propVal;
@@ -804,6 +1713,8 @@ namespace {
               sl.add("real", propVal[0]);
               sl.add("imaginary", propVal[1]);
               sl.pop();
+              propValue.number_ = propVal[0];
+              propValue.raw_ = get_value_bytes(propVal);
             }break;
             case tdmsTypeComplexDoubleFloat: {
               double propVal[2]{ 0., 0. };
@@ -813,6 +1724,8 @@ namespace {
               sl.add("real", propVal[0]);
               sl.add("imaginary", propVal[1]);
               sl.pop();
+              propValue.number_ = propVal[0];
+              propValue.raw_ = get_value_bytes(propVal);
             }break;
             case tdmsTypeDAQmxRawData: {
               throw std::logic_error("property can not be daqmx");
@@ -822,6 +1735,11 @@ namespace {
               break;
             }
             sl.pop();
+
+            // later segments overwrite the value of a property
+            if (nullptr != layout) {
+              layout->properties_[objPath][propName] = propValue;
+            }
           }
           sl.pop();
 
@@ -835,20 +1753,28 @@ namespace {
         // determine number of chunks
 
         uint64_t raw_data_size_of_one_chunk{ 0LL };
+        // all DAQmx channels of a segment share the same raw buffers
+        uint64_t daqmx_raw_data_size_of_one_chunk{ 0LL };
 
         for (const auto& sgmtRawInfo : objectRawInfosCurr) {
+          if (tdmsTypeDAQmxRawData == sgmtRawInfo.datatype_) {
+            daqmx_raw_data_size_of_one_chunk = std::max(daqmx_raw_data_size_of_one_chunk, sgmtRawInfo.daqmx_chunk_size());
+            continue;
+          }
+
           // 1. Calculate the raw data size of a channel.Each channel has a Data type, 
           //    Array dimension and Number of values in meta information.
           //    Refer to the Meta Data section of this article for details.
           //    Each Data type is associated with a type size.You can get the raw data size of the channel by:
           //    type size of Data type × Array dimension × Number of values.
           //    If Total size in bytes is valid, then the raw data size of the channel is this value.
-          uint64_t raw_data_size_of_a_channel = 0 != sgmtRawInfo.second.total_size_in_byte_? sgmtRawInfo.second.total_size_in_byte_ :
-            uint64_t(get_tdms_data_type_byte_size(sgmtRawInfo.second.datatype_)) * sgmtRawInfo.second.dimension_ * sgmtRawInfo.second.number_of_values_;
+          uint64_t raw_data_size_of_a_channel = 0 != sgmtRawInfo.total_size_in_byte_? sgmtRawInfo.total_size_in_byte_ :
+            uint64_t(get_tdms_data_type_byte_size(sgmtRawInfo.datatype_)) * sgmtRawInfo.dimension_ * sgmtRawInfo.number_of_values_;
 
           // 2. Calculate the raw data size of one chunk by accumulating the raw data size of all channels.
           raw_data_size_of_one_chunk += raw_data_size_of_a_channel;
         }
+        raw_data_size_of_one_chunk += daqmx_raw_data_size_of_one_chunk;
         // 3. Calculate the raw data size of total chunks by : Next segment offset - Raw data offset.
         //    If the value of Next segment offset is - 1, the raw data size of total chunks equals the 
         //    file size minus the absolute beginning position of the raw data.
@@ -856,6 +1782,29 @@ namespace {
         // 4. Calculate the number of chunks by : Raw data size of total chunks / Raw data size of one chunk.
         uint64_t  number_of_chunks = 0 != raw_data_size_of_one_chunk ? raw_data_size_of_total_chunks / raw_data_size_of_one_chunk : 1;
 
+        if (nullptr != layout) {
+          SgmtLayout& sgmtLayout = layout->segments_.back();
+          sgmtLayout.chunk_size_ = raw_data_size_of_one_chunk;
+          sgmtLayout.number_of_chunks_ = 0 != raw_data_size_of_one_chunk ? number_of_chunks : 0;
+          uint64_t offset_in_chunk{ 0LL };
+          for (const auto& sgmtRawInfo : objectRawInfosCurr) {
+            SgmtChannelLayout channelLayout;
+            channelLayout.rawInfo_ = sgmtRawInfo;
+            if (tdmsTypeDAQmxRawData == sgmtRawInfo.datatype_) {
+              // DAQmx channels are located by their scalers inside the shared raw buffers
+              channelLayout.size_in_chunk_ = daqmx_raw_data_size_of_one_chunk;
+              sgmtLayout.channels_.push_back(channelLayout);
+              continue;
+            }
+            channelLayout.offset_in_chunk_ = offset_in_chunk;
+            channelLayout.size_in_chunk_ = 0 != sgmtRawInfo.total_size_in_byte_ ? sgmtRawInfo.total_size_in_byte_ :
+              channelLayout.value_size() * sgmtRawInfo.number_of_values_;
+            // in interleaved segments the offset is relative to the start of a row
+            offset_in_chunk += sgmtHeader.toc.InterleavedData ? channelLayout.value_size() : channelLayout.size_in_chunk_;
+            sgmtLayout.channels_.push_back(channelLayout);
+          }
+        }
+
         sl.push("channel_data");
           sl.add("absolut_raw_data_byte_start", raw_data_absolute_offset_in_byte);
           sl.add("absolut_raw_data_byte_end", sgmtStartOffset + next_segment_offset);
@@ -865,12 +1814,12 @@ namespace {
           sl.push("channels");
           for (const auto& sgmtRawInfo : objectRawInfosCurr) {
             sl.push("channel");
-            sl.add("path", sgmtRawInfo.second.objPath_);
-            sl.add("data_type", sgmtRawInfo.second.datatype_);
-            sl.add("data_type_string", get_tdms_data_type_as_string(sgmtRawInfo.second.datatype_));
-            sl.add("data_type_single_value_size", get_tdms_data_type_byte_size(sgmtRawInfo.second.datatype_));
-            sl.add("number_of_values_in_chunk", sgmtRawInfo.second.number_of_values_);
-            sl.add("number_of_values_in_segment", sgmtRawInfo.second.number_of_values_ * number_of_chunks);
+            sl.add("path", sgmtRawInfo.objPath_);
+            sl.add("data_type", sgmtRawInfo.datatype_);
+            sl.add("data_type_string", get_tdms_data_type_as_string(sgmtRawInfo.datatype_));
+            sl.add("data_type_single_value_size", get_tdms_data_type_byte_size(sgmtRawInfo.datatype_));
+            sl.add("number_of_values_in_chunk", sgmtRawInfo.number_of_values_);
+            sl.add("number_of_values_in_segment", sgmtRawInfo.number_of_values_ * number_of_chunks);
             sl.pop();
           }
           sl.pop();
@@ -882,24 +1831,7438 @@ namespace {
     sl.pop();
 
     sl.add("segments_count", sgmtIndex);
+    if (nullptr != layout && !segmentStillWritten) {
+      layout->parse_state_ = TdmsParseState{ next_segment_absolute_offset, sgmtIndex, std::move(objectRawInfosAll), std::move(objectRawInfosCurr) };
+    }
+    if (nullptr != hashes) {
+      sl.add("tree_hash", format_hash(hashes->tree_));
+    }
     sl.pop();
   }
 
-}
+  /**
+   * @brief Identity of a file used to decide if a cached layout still describes it
+   */
+  class FileIdentity
+  {
+  public:
+    uint64_t device_{ 0LL };
+    uint64_t inode_{ 0LL };
+    uint64_t size_{ 0LL };
+    int64_t modification_time_{ 0LL };
+  };
 
+  /**
+   * @brief Get device, inode (file index on windows), size and modification time of a file
+   */
+  template<class PathType> FileIdentity get_file_identity(const PathType& filePath)
+  {
+    const std::filesystem::path path(filePath);
+    FileIdentity identity;
+    identity.size_ = std::filesystem::file_size(path);
+    identity.modification_time_ = int64_t(std::filesystem::last_write_time(path).time_since_epoch().count());
+#if defined(_WIN32)
+    const HANDLE file = CreateFileW(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (INVALID_HANDLE_VALUE != file) {
+      BY_HANDLE_FILE_INFORMATION information;
+      if (GetFileInformationByHandle(file, &information)) {
+        identity.device_ = information.dwVolumeSerialNumber;
+        identity.inode_ = (uint64_t(information.nFileIndexHigh) << 32) | information.nFileIndexLow;
+      }
+      CloseHandle(file);
+    }
+#elif defined(TDMS_MMAP)
+    struct stat fileStat;
+    if (0 == stat(path.c_str(), &fileStat)) {
+      identity.device_ = uint64_t(fileStat.st_dev);
+      identity.inode_ = uint64_t(fileStat.st_ino);
+    }
+#endif
+    return identity;
+  }
 
-int main(int argc, char const *argv[])
-{
-    if(argc < 2) {
-      std::cout << "USAGE: log_tdms_file_structure TDMSFILEPATH [XMLFILEPATH]" << std::endl;
-      return -1;
+  /**
+   * @brief Get a FNV-1a hash over the lead in and meta data of the first segment. A file that
+   *        only grew still starts with the same first segment.
+   */
+  template<class PathType> uint64_t get_first_segment_key(const PathType& tdmsFilePath)
+  {
+    constexpr size_t leadInSizeInByte{ sizeof(SgmtHeader) + sizeof(uint32_t) + 2 * sizeof(uint64_t) };
+    FileIo fileIo(tdmsFilePath);
+    std::vector<uint8_t> bytes(leadInSizeInByte);
+    if (!fileIo.read_no_throw(bytes.data(), leadInSizeInByte)) {
+      return 0;
     }
-    
-    std::string tdmsFilePath = argv[1];
-    std::string xmlResultFilePath = argc > 2 ? argv[2] : tdmsFilePath + ".structure.xml";
-    try {
+    SgmtHeader sgmtHeader;
+    std::memcpy(&sgmtHeader, bytes.data(), sizeof(SgmtHeader));
+    const uint64_t rawDataOffset = decode_lead_in_value(bytes.data() + 20, 8, sgmtHeader.toc.BigEndian);
+    if (rawDataOffset <= fileIo.size() - leadInSizeInByte) {
+      bytes.resize(leadInSizeInByte + rawDataOffset);
+      fileIo.read_bytes(bytes.data() + leadInSizeInByte, rawDataOffset);
+    }
+    uint64_t key = 0xcbf29ce484222325ULL;
+    for (const uint8_t byte : bytes) {
+      key = (key ^ byte) * 0x100000001b3ULL;
+    }
+    return key;
+  }
+
+  /**
+   * @brief Serialize a layout into the byte order of the operating system
+   */
+  class LayoutCacheWriter
+  {
+  public:
+    template<class T> void write_value(const T& value)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "only plain values can be written");
+      const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+      buffer_.insert(buffer_.end(), bytes, bytes + sizeof(T));
+    }
+
+    void write_string(const std::string& value)
+    {
+      write_value(uint64_t(value.size()));
+      buffer_.insert(buffer_.end(), value.begin(), value.end());
+    }
+
+    void write_bytes(const std::vector<uint8_t>& value)
+    {
+      write_value(uint64_t(value.size()));
+      buffer_.insert(buffer_.end(), value.begin(), value.end());
+    }
+
+    void write_raw_info(const SgmtObjectRawInfo& rawInfo)
+    {
+      write_string(rawInfo.objPath_);
+      write_value(uint32_t(rawInfo.datatype_));
+      write_value(rawInfo.dimension_);
+      write_value(rawInfo.number_of_values_);
+      write_value(rawInfo.total_size_in_byte_);
+      write_value(uint64_t(rawInfo.daqmx_scalers_.size()));
+      for (const auto& scaler : rawInfo.daqmx_scalers_) {
+        write_value(scaler.data_type_);
+        write_value(scaler.raw_buffer_index_);
+        write_value(scaler.byte_offset_within_stride_);
+        write_value(scaler.bit_offset_within_byte_);
+        write_value(scaler.sample_format_bitmap_);
+        write_value(scaler.scale_id_);
+        write_value(uint8_t(scaler.digital_line_));
+      }
+      write_value(uint64_t(rawInfo.daqmx_raw_data_widths_.size()));
+      for (const auto width : rawInfo.daqmx_raw_data_widths_) {
+        write_value(width);
+      }
+    }
+
+    void write_layout(const TdmsFileLayout& layout)
+    {
+      write_value(layout.size_);
+      write_value(uint64_t(layout.segments_.size()));
+      for (const auto& segment : layout.segments_) {
+        write_value(int64_t(segment.index_));
+        write_value(segment.absolute_offset_);
+        write_value(segment.raw_data_absolute_offset_);
+        write_value(segment.raw_data_absolute_end_);
+        write_value(segment.chunk_size_);
+        write_value(segment.number_of_chunks_);
+        write_value(uint8_t(segment.interleaved_));
+        write_value(uint8_t(segment.big_endian_));
+        write_value(uint8_t(segment.daqmx_));
+        write_value(uint64_t(segment.channels_.size()));
+        for (const auto& channel : segment.channels_) {
+          write_raw_info(channel.rawInfo_);
+          write_value(channel.offset_in_chunk_);
+          write_value(channel.size_in_chunk_);
+        }
+      }
+      write_value(uint64_t(layout.properties_.size()));
+      for (const auto& objectProperties : layout.properties_) {
+        write_string(objectProperties.first);
+        write_value(uint64_t(objectProperties.second.size()));
+        for (const auto& property : objectProperties.second) {
+          write_string(property.first);
+          write_value(uint32_t(property.second.datatype_));
+          write_value(property.second.number_);
+          write_string(property.second.string_);
+          write_bytes(property.second.raw_);
+        }
+      }
+      const TdmsParseState& parseState = layout.parse_state_;
+      write_value(parseState.segment_absolute_offset_);
+      write_value(int64_t(parseState.segment_index_));
+      write_value(uint64_t(parseState.object_raw_infos_all_.size()));
+      for (const auto& rawInfo : parseState.object_raw_infos_all_) {
+        write_raw_info(rawInfo.second);
+      }
+      write_value(uint64_t(parseState.object_raw_infos_curr_.size()));
+      for (const auto& rawInfo : parseState.object_raw_infos_curr_) {
+        write_raw_info(rawInfo);
+      }
+    }
+
+    const std::vector<uint8_t>& buffer() const
+    {
+      return buffer_;
+    }
+
+  private:
+    std::vector<uint8_t> buffer_;
+  };
+
+  /**
+   * @brief Deserialize a layout written by LayoutCacheWriter
+   */
+  class LayoutCacheReader
+  {
+  public:
+    explicit LayoutCacheReader(std::vector<uint8_t> buffer) : buffer_(std::move(buffer))
+    {
+    }
+
+    template<class T> T read_value()
+    {
+      if (sizeof(T) > buffer_.size() - position_) {
+        throw std::logic_error("Layout cache is truncated");
+      }
+      T value;
+      std::memcpy(&value, buffer_.data() + position_, sizeof(T));
+      position_ += sizeof(T);
+      return value;
+    }
+
+    std::string read_string()
+    {
+      const uint64_t size = read_count(1);
+      std::string value(reinterpret_cast<const char*>(buffer_.data() + position_), size_t(size));
+      position_ += size_t(size);
+      return value;
+    }
+
+    std::vector<uint8_t> read_bytes()
+    {
+      const uint64_t size = read_count(1);
+      std::vector<uint8_t> value(buffer_.data() + position_, buffer_.data() + position_ + size_t(size));
+      position_ += size_t(size);
+      return value;
+    }
+
+    SgmtObjectRawInfo read_raw_info()
+    {
+      SgmtObjectRawInfo rawInfo;
+      rawInfo.objPath_ = read_string();
+      rawInfo.datatype_ = tdmsDataType(read_value<uint32_t>());
+      rawInfo.dimension_ = read_value<uint32_t>();
+      rawInfo.number_of_values_ = read_value<uint64_t>();
+      rawInfo.total_size_in_byte_ = read_value<uint64_t>();
+      rawInfo.daqmx_scalers_.resize(size_t(read_count(25)));
+      for (auto& scaler : rawInfo.daqmx_scalers_) {
+        scaler.data_type_ = read_value<uint32_t>();
+        scaler.raw_buffer_index_ = read_value<uint32_t>();
+        scaler.byte_offset_within_stride_ = read_value<uint32_t>();
+        scaler.bit_offset_within_byte_ = read_value<uint32_t>();
+        scaler.sample_format_bitmap_ = read_value<uint32_t>();
+        scaler.scale_id_ = read_value<uint32_t>();
+        scaler.digital_line_ = 0 != read_value<uint8_t>();
+      }
+      rawInfo.daqmx_raw_data_widths_.resize(size_t(read_count(sizeof(uint32_t))));
+      for (auto& width : rawInfo.daqmx_raw_data_widths_) {
+        width = read_value<uint32_t>();
+      }
+      return rawInfo;
+    }
+
+    void read_layout(TdmsFileLayout& layout)
+    {
+      layout.size_ = read_value<uint64_t>();
+      layout.segments_.resize(size_t(read_count(59)));
+      for (auto& segment : layout.segments_) {
+        segment.index_ = long(read_value<int64_t>());
+        segment.absolute_offset_ = read_value<uint64_t>();
+        segment.raw_data_absolute_offset_ = read_value<uint64_t>();
+        segment.raw_data_absolute_end_ = read_value<uint64_t>();
+        segment.chunk_size_ = read_value<uint64_t>();
+        segment.number_of_chunks_ = read_value<uint64_t>();
+        segment.interleaved_ = 0 != read_value<uint8_t>();
+        segment.big_endian_ = 0 != read_value<uint8_t>();
+        segment.daqmx_ = 0 != read_value<uint8_t>();
+        segment.channels_.resize(size_t(read_count(64)));
+        for (auto& channel : segment.channels_) {
+          channel.rawInfo_ = read_raw_info();
+          channel.offset_in_chunk_ = read_value<uint64_t>();
+          channel.size_in_chunk_ = read_value<uint64_t>();
+        }
+      }
+      const uint64_t objectCount = read_count(16);
+      for (uint64_t objectIndex = 0; objectIndex < objectCount; ++objectIndex) {
+        ObjectProperties& properties = layout.properties_[read_string()];
+        const uint64_t propertyCount = read_count(36);
+        for (uint64_t propertyIndex = 0; propertyIndex < propertyCount; ++propertyIndex) {
+          PropertyValue& property = properties[read_string()];
+          property.datatype_ = tdmsDataType(read_value<uint32_t>());
+          property.number_ = read_value<double>();
+          property.string_ = read_string();
+          property.raw_ = read_bytes();
+        }
+      }
+      TdmsParseState& parseState = layout.parse_state_;
+      parseState.segment_absolute_offset_ = read_value<int64_t>();
+      parseState.segment_index_ = long(read_value<int64_t>());
+      const uint64_t allCount = read_count(48);
+      for (uint64_t rawInfoIndex = 0; rawInfoIndex < allCount; ++rawInfoIndex) {
+        SgmtObjectRawInfo rawInfo = read_raw_info();
+        parseState.object_raw_infos_all_[rawInfo.objPath_] = rawInfo;
+      }
+      parseState.object_raw_infos_curr_.resize(size_t(read_count(48)));
+      for (auto& rawInfo : parseState.object_raw_infos_curr_) {
+        rawInfo = read_raw_info();
+      }
+      if (position_ != buffer_.size() || parseState.segment_index_ < 0 || size_t(parseState.segment_index_) > layout.segments_.size()) {
+        throw std::logic_error("Layout cache is corrupt");
+      }
+    }
+
+  private:
+    /**
+     * @brief Read the number of following elements and check that they can fit into the buffer
+     */
+    uint64_t read_count(const size_t minimalElementSize)
+    {
+      const uint64_t count = read_value<uint64_t>();
+      if (count > (buffer_.size() - position_) / minimalElementSize) {
+        throw std::logic_error("Layout cache is corrupt");
+      }
+      return count;
+    }
+
+    std::vector<uint8_t> buffer_;
+    size_t position_{ 0 };
+  };
+
+  /**
+   * @brief Determine the layout of a tdms file using a persistent cache. The cache file is named
+   *        by device and inode of the tdms file and written in the byte order of the operating
+   *        system:
+   * 
+   *        char[4]   "TDSc"
+   *        uint32    version 2
+   *        uint64    device, inode and size of the tdms file
+   *        int64     modification time of the tdms file
+   *        uint64    key of the first segment, see get_first_segment_key
+   *        layout    as written by LayoutCacheWriter::write_layout
+   * 
+   *        An unchanged file is not parsed at all. If the file only grew, parsing continues after
+   *        the cached segments and the cache is updated. Otherwise the file is parsed again.
+   *        Failing to write the cache does not fail reading the layout.
+   * 
+   * @param tdmsFilePath    path of the tdms file
+   * @param cacheDirectory  directory containing the cache files
+   * @param useIndexFile    read the meta data from .tdms_index files if available
+   * @return layout of all segments
+   */
+  template<class PathType> TdmsFileLayout read_tdms_file_layout_cached(const PathType& tdmsFilePath, const std::filesystem::path& cacheDirectory,
+    const bool useIndexFile = true)
+  {
+    constexpr uint32_t cacheVersion{ 2 };
+    const FileIdentity identity = get_file_identity(tdmsFilePath);
+    const uint64_t firstSegmentKey = get_first_segment_key(tdmsFilePath);
+    std::ostringstream cacheFileName;
+    cacheFileName << std::hex << identity.device_ << "-" << identity.inode_ << ".tdms_layout";
+    const std::filesystem::path cacheFilePath = cacheDirectory / cacheFileName.str();
+
+    TdmsFileLayout layout;
+    bool cacheUpToDate{ false };
+    std::error_code errorCode;
+    if (0 != identity.inode_ && std::filesystem::is_regular_file(cacheFilePath, errorCode)) {
+      try {
+        FileIo cacheIo(cacheFilePath);
+        std::vector<uint8_t> buffer(size_t(cacheIo.size()));
+        cacheIo.read_bytes(buffer.data(), buffer.size());
+        LayoutCacheReader reader(std::move(buffer));
+        if ('T' == reader.read_value<char>() && 'D' == reader.read_value<char>() && 'S' == reader.read_value<char>() && 'c' == reader.read_value<char>() &&
+          cacheVersion == reader.read_value<uint32_t>() && identity.device_ == reader.read_value<uint64_t>() && identity.inode_ == reader.read_value<uint64_t>()) {
+          const uint64_t cachedSize = reader.read_value<uint64_t>();
+          const int64_t cachedModificationTime = reader.read_value<int64_t>();
+          if (firstSegmentKey == reader.read_value<uint64_t>() && cachedSize <= identity.size_) {
+            reader.read_layout(layout);
+            cacheUpToDate = cachedSize == identity.size_ && cachedModificationTime == identity.modification_time_;
+            if (!cacheUpToDate && layout.segments_.empty()) {
+              layout = TdmsFileLayout();
+            }
+          }
+        }
+      }
+      catch (const std::exception&) {
+        // parse the file again
+        layout = TdmsFileLayout();
+      }
+    }
+    if (cacheUpToDate) {
+      return layout;
+    }
+
+    // continues after the cached segments if there are any
+    ContentLoggerNull nl;
+    log_tdms_file_structure(tdmsFilePath, nl, &layout, nullptr, useIndexFile);
+
+    if (0 != identity.inode_) {
+      try {
+        LayoutCacheWriter writer;
+        writer.write_value(std::array<char, 4>{ 'T', 'D', 'S', 'c' });
+        writer.write_value(cacheVersion);
+        writer.write_value(identity.device_);
+        writer.write_value(identity.inode_);
+        writer.write_value(identity.size_);
+        writer.write_value(identity.modification_time_);
+        writer.write_value(firstSegmentKey);
+        writer.write_layout(layout);
+        // replace the cache at once so concurrent readers never see a partial file
+        std::filesystem::create_directories(cacheDirectory);
+        std::filesystem::path temporaryFilePath = cacheFilePath;
+        temporaryFilePath += "." + std::to_string(std::random_device()()) + ".tmp";
+        {
+          std::ofstream ofs(temporaryFilePath, std::ios::binary | std::ios::out | std::ios::trunc);
+          ofs.write(reinterpret_cast<const char*>(writer.buffer().data()), std::streamsize(writer.buffer().size()));
+          if (!ofs) {
+            throw std::logic_error("Failed to write layout cache");
+          }
+        }
+        std::filesystem::rename(temporaryFilePath, cacheFilePath);
+      }
+      catch (const std::exception&) {
+        // the layout is valid even if it could not be cached
+      }
+    }
+    return layout;
+  }
+
+  /**
+   * @brief Determine the raw data layout of a tdms file without logging its structure. If the
+   *        environment variable TDMS_CACHE_DIR is set the layout is cached in this directory.
+   * 
+   * @tparam PathType     std::string or std::wstring to support utf8 and utf16
+   * @param tdmsFilePath  path of the tdms file
+   * @param useIndexFile  read the meta data from .tdms_index files if available
+   * @return layout of all segments
+   */
+  template<class PathType> TdmsFileLayout read_tdms_file_layout(const PathType& tdmsFilePath, const bool useIndexFile = true)
+  {
+    const char* cacheDirectory = std::getenv("TDMS_CACHE_DIR");
+    if (nullptr != cacheDirectory && 0 != *cacheDirectory) {
+      return read_tdms_file_layout_cached(tdmsFilePath, std::filesystem::u8path(cacheDirectory), useIndexFile);
+    }
+    TdmsFileLayout layout;
+    ContentLoggerNull nl;
+    log_tdms_file_structure(tdmsFilePath, nl, &layout, nullptr, useIndexFile);
+    return layout;
+  }
+
+  /**
+   * @brief Instruction set extensions used by the bulk kernels
+   */
+  enum SimdLevel {
+    simdLevelScalar = 0,
+    simdLevelSse2 = 1,
+    simdLevelSsse3 = 2,
+    simdLevelAvx2 = 3
+  };
+
+  /**
+   * @brief Determine the best instruction set supported by the cpu. Can be lowered using the
+   *        environment variable TDMS_SIMD set to scalar, sse2, ssse3 or avx2.
+   * 
+   * @return instruction set used by the bulk kernels
+   */
+  SimdLevel detect_simd_level()
+  {
+    SimdLevel simdLevel{ simdLevelScalar };
+#if defined(TDMS_X86)
+#if defined(_MSC_VER)
+    int cpuInfo[4];
+    __cpuid(cpuInfo, 0);
+    const int maxLeaf = cpuInfo[0];
+    __cpuid(cpuInfo, 1);
+    const bool osSupportsAvx = (cpuInfo[2] & (1 << 27)) && (cpuInfo[2] & (1 << 28)) && 6 == (_xgetbv(0) & 6);
+    simdLevel = (cpuInfo[3] & (1 << 26)) ? simdLevelSse2 : simdLevelScalar;
+    if (cpuInfo[2] & (1 << 9)) {
+      simdLevel = simdLevelSsse3;
+    }
+    if (maxLeaf >= 7 && osSupportsAvx) {
+      __cpuidex(cpuInfo, 7, 0);
+      if (cpuInfo[1] & (1 << 5)) {
+        simdLevel = simdLevelAvx2;
+      }
+    }
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+      simdLevel = simdLevelSse2;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+      simdLevel = simdLevelSsse3;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+      simdLevel = simdLevelAvx2;
+    }
+#endif
+#endif
+
+    const char* requested = std::getenv("TDMS_SIMD");
+    if (nullptr != requested) {
+      const std::string requestedLevel(requested);
+      if ("scalar" == requestedLevel) {
+        simdLevel = simdLevelScalar;
+      }
+      else if ("sse2" == requestedLevel) {
+        simdLevel = std::min(simdLevel, simdLevelSse2);
+      }
+      else if ("ssse3" == requestedLevel) {
+        simdLevel = std::min(simdLevel, simdLevelSsse3);
+      }
+    }
+    return simdLevel;
+  }
+
+  /**
+   * @brief Get the instruction set used by the bulk kernels. Detected once.
+   */
+  SimdLevel get_simd_level()
+  {
+    static const SimdLevel simdLevel = detect_simd_level();
+    return simdLevel;
+  }
+
+  /**
+   * @brief Destination of a single channel when de-interleaving rows of values
+   */
+  struct DeinterleaveColumn
+  {
+    uint64_t offset_in_row;
+    uint64_t value_size;
+    uint8_t* dst;
+  };
+
+  /**
+   * @brief Copy a strided column of values of fixed size into a contiguous array
+   * 
+   * @tparam W          size of a value in bytes
+   * @param src         first value of the column
+   * @param rowSize     distance between two values in bytes
+   * @param rowCount    number of values to copy
+   * @param dst         contiguous destination
+   */
+  template<int W> void deinterleave_column_scalar(const uint8_t* src, const uint64_t rowSize, const uint64_t rowCount, uint8_t* dst)
+  {
+    for (uint64_t rowIndex = 0; rowIndex < rowCount; ++rowIndex, src += rowSize, dst += W) {
+      std::memcpy(dst, src, W);
+    }
+  }
+
+  /**
+   * @brief Copy a strided column of values of arbitrary size into a contiguous array
+   */
+  void deinterleave_column_scalar(const uint8_t* src, const uint64_t rowSize, const uint64_t rowCount, const uint64_t valueSize, uint8_t* dst)
+  {
+    switch (valueSize) {
+    case 1: deinterleave_column_scalar<1>(src, rowSize, rowCount, dst); break;
+    case 2: deinterleave_column_scalar<2>(src, rowSize, rowCount, dst); break;
+    case 4: deinterleave_column_scalar<4>(src, rowSize, rowCount, dst); break;
+    case 8: deinterleave_column_scalar<8>(src, rowSize, rowCount, dst); break;
+    case 16: deinterleave_column_scalar<16>(src, rowSize, rowCount, dst); break;
+    default:
+      for (uint64_t rowIndex = 0; rowIndex < rowCount; ++rowIndex, src += rowSize, dst += valueSize) {
+        std::memcpy(dst, src, valueSize);
+      }
+      break;
+    }
+  }
+
+#if defined(TDMS_X86)
+  template<int W> __m128i unpack_lo_sse2(__m128i a, __m128i b);
+  template<int W> __m128i unpack_hi_sse2(__m128i a, __m128i b);
+  template<> TDMS_TARGET("sse2") inline __m128i unpack_lo_sse2<1>(__m128i a, __m128i b) { return _mm_unpacklo_epi8(a, b); }
+  template<> TDMS_TARGET("sse2") inline __m128i unpack_hi_sse2<1>(__m128i a, __m128i b) { return _mm_unpackhi_epi8(a, b); }
+  template<> TDMS_TARGET("sse2") inline __m128i unpack_lo_sse2<2>(__m128i a, __m128i b) { return _mm_unpacklo_epi16(a, b); }
+  template<> TDMS_TARGET("sse2") inline __m128i unpack_hi_sse2<2>(__m128i a, __m128i b) { return _mm_unpackhi_epi16(a, b); }
+  template<> TDMS_TARGET("sse2") inline __m128i unpack_lo_sse2<4>(__m128i a, __m128i b) { return _mm_unpacklo_epi32(a, b); }
+  template<> TDMS_TARGET("sse2") inline __m128i unpack_hi_sse2<4>(__m128i a, __m128i b) { return _mm_unpackhi_epi32(a, b); }
+  template<> TDMS_TARGET("sse2") inline __m128i unpack_lo_sse2<8>(__m128i a, __m128i b) { return _mm_unpacklo_epi64(a, b); }
+  template<> TDMS_TARGET("sse2") inline __m128i unpack_hi_sse2<8>(__m128i a, __m128i b) { return _mm_unpackhi_epi64(a, b); }
+
+  template<int W> __m256i unpack_lo_avx2(__m256i a, __m256i b);
+  template<int W> __m256i unpack_hi_avx2(__m256i a, __m256i b);
+  template<> TDMS_TARGET("avx2") inline __m256i unpack_lo_avx2<1>(__m256i a, __m256i b) { return _mm256_unpacklo_epi8(a, b); }
+  template<> TDMS_TARGET("avx2") inline __m256i unpack_hi_avx2<1>(__m256i a, __m256i b) { return _mm256_unpackhi_epi8(a, b); }
+  template<> TDMS_TARGET("avx2") inline __m256i unpack_lo_avx2<2>(__m256i a, __m256i b) { return _mm256_unpacklo_epi16(a, b); }
+  template<> TDMS_TARGET("avx2") inline __m256i unpack_hi_avx2<2>(__m256i a, __m256i b) { return _mm256_unpackhi_epi16(a, b); }
+  template<> TDMS_TARGET("avx2") inline __m256i unpack_lo_avx2<4>(__m256i a, __m256i b) { return _mm256_unpacklo_epi32(a, b); }
+  template<> TDMS_TARGET("avx2") inline __m256i unpack_hi_avx2<4>(__m256i a, __m256i b) { return _mm256_unpackhi_epi32(a, b); }
+  template<> TDMS_TARGET("avx2") inline __m256i unpack_lo_avx2<8>(__m256i a, __m256i b) { return _mm256_unpacklo_epi64(a, b); }
+  template<> TDMS_TARGET("avx2") inline __m256i unpack_hi_avx2<8>(__m256i a, __m256i b) { return _mm256_unpackhi_epi64(a, b); }
+
+  /**
+   * @brief Transpose a group of 16/W adjacent columns of W byte values. Blocks of 16/W rows are
+   *        loaded into registers and transposed by log2(16/W) rounds of unpacking with W byte
+   *        granularity.
+   * 
+   * @tparam W        size of a value in bytes
+   * @param src       first value of the first column of the group
+   * @param rowSize   distance between two rows in bytes
+   * @param rowCount  number of rows to transpose
+   * @param dsts      contiguous destinations of the 16/W columns
+   */
+  template<int W> TDMS_TARGET("sse2") void deinterleave_group_sse2(const uint8_t* src, const uint64_t rowSize, const uint64_t rowCount, uint8_t* const* dsts)
+  {
+    constexpr int V = 16 / W;
+    uint64_t rowIndex = 0;
+    for (; rowIndex + V <= rowCount; rowIndex += V) {
+      __m128i r[V];
+      for (int i = 0; i < V; ++i) {
+        r[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (rowIndex + i) * rowSize));
+      }
+      for (int round = 1; round < V; round *= 2) {
+        __m128i n[V];
+        for (int i = 0; i < V / 2; ++i) {
+          n[2 * i] = unpack_lo_sse2<W>(r[i], r[i + V / 2]);
+          n[2 * i + 1] = unpack_hi_sse2<W>(r[i], r[i + V / 2]);
+        }
+        for (int i = 0; i < V; ++i) {
+          r[i] = n[i];
+        }
+      }
+      for (int i = 0; i < V; ++i) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dsts[i] + rowIndex * W), r[i]);
+      }
+    }
+    for (int i = 0; i < V; ++i) {
+      deinterleave_column_scalar<W>(src + rowIndex * rowSize + i * W, rowSize, rowCount - rowIndex, dsts[i] + rowIndex * W);
+    }
+  }
+
+  /**
+   * @brief Same as deinterleave_group_sse2 but transposing two blocks of rows at once. The
+   *        unpack instructions work per 128 bit lane, so the lower lane holds the first and the
+   *        upper lane the second block.
+   */
+  template<int W> TDMS_TARGET("avx2") void deinterleave_group_avx2(const uint8_t* src, const uint64_t rowSize, const uint64_t rowCount, uint8_t* const* dsts)
+  {
+    constexpr int V = 16 / W;
+    uint64_t rowIndex = 0;
+    for (; rowIndex + 2 * V <= rowCount; rowIndex += 2 * V) {
+      __m256i r[V];
+      for (int i = 0; i < V; ++i) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (rowIndex + i) * rowSize));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (rowIndex + V + i) * rowSize));
+        r[i] = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+      }
+      for (int round = 1; round < V; round *= 2) {
+        __m256i n[V];
+        for (int i = 0; i < V / 2; ++i) {
+          n[2 * i] = unpack_lo_avx2<W>(r[i], r[i + V / 2]);
+          n[2 * i + 1] = unpack_hi_avx2<W>(r[i], r[i + V / 2]);
+        }
+        for (int i = 0; i < V; ++i) {
+          r[i] = n[i];
+        }
+      }
+      for (int i = 0; i < V; ++i) {
+        // both lanes are adjacent in the destination
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dsts[i] + rowIndex * W), r[i]);
+      }
+    }
+    uint8_t* tailDsts[V];
+    for (int i = 0; i < V; ++i) {
+      tailDsts[i] = dsts[i] + rowIndex * W;
+    }
+    deinterleave_group_sse2<W>(src + rowIndex * rowSize, rowSize, rowCount - rowIndex, tailDsts);
+  }
+
+  /**
+   * @brief Copy a strided column of 4 or 8 byte values using gather instructions
+   */
+  template<int W> TDMS_TARGET("avx2") void deinterleave_column_avx2(const uint8_t* src, const uint64_t rowSize, const uint64_t rowCount, uint8_t* dst)
+  {
+    uint64_t rowIndex = 0;
+    if (rowSize <= 0x0FFFFFFF) {
+      const int stride = static_cast<int>(rowSize);
+      if (4 == W) {
+        const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+        for (; rowIndex + 8 <= rowCount; rowIndex += 8) {
+          const __m256i values = _mm256_i32gather_epi32(reinterpret_cast<const int*>(src + rowIndex * rowSize), offsets, 1);
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + rowIndex * W), values);
+        }
+      }
+      else {
+        const __m128i offsets = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(stride));
+        for (; rowIndex + 4 <= rowCount; rowIndex += 4) {
+          const __m256i values = _mm256_i32gather_epi64(reinterpret_cast<const long long*>(src + rowIndex * rowSize), offsets, 1);
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + rowIndex * W), values);
+        }
+      }
+    }
+    deinterleave_column_scalar<W>(src + rowIndex * rowSize, rowSize, rowCount - rowIndex, dst + rowIndex * W);
+  }
+#endif
+
+  /**
+   * @brief Transpose a group of 16/W adjacent columns of W byte values using the best available kernel
+   */
+  template<int W> void deinterleave_group(const uint8_t* src, const uint64_t rowSize, const uint64_t rowCount, uint8_t* const* dsts)
+  {
+#if defined(TDMS_X86)
+    const SimdLevel simdLevel = get_simd_level();
+    if (simdLevel >= simdLevelAvx2) {
+      deinterleave_group_avx2<W>(src, rowSize, rowCount, dsts);
+      return;
+    }
+    if (simdLevel >= simdLevelSse2) {
+      deinterleave_group_sse2<W>(src, rowSize, rowCount, dsts);
+      return;
+    }
+#endif
+    for (int i = 0; i < 16 / W; ++i) {
+      deinterleave_column_scalar<W>(src + i * W, rowSize, rowCount, dsts[i]);
+    }
+  }
+
+  /**
+   * @brief Copy a single strided column using the best available kernel
+   */
+  void deinterleave_column(const uint8_t* src, const uint64_t rowSize, const uint64_t rowCount, const uint64_t valueSize, uint8_t* dst)
+  {
+#if defined(TDMS_X86)
+    if (get_simd_level() >= simdLevelAvx2) {
+      switch (valueSize) {
+      case 4: deinterleave_column_avx2<4>(src, rowSize, rowCount, dst); return;
+      case 8: deinterleave_column_avx2<8>(src, rowSize, rowCount, dst); return;
+      default: break;
+      }
+    }
+#endif
+    deinterleave_column_scalar(src, rowSize, rowCount, valueSize, dst);
+  }
+
+  /**
+   * @brief De-interleave rows of values into contiguous arrays, one per requested column.
+   *        Runs of adjacent requested columns sharing a value size of 1, 2, 4 or 8 bytes are
+   *        transposed in register blocks, all other columns are gathered one by one. Rows are
+   *        processed in tiles small enough to stay in the cache while all columns consume them.
+   * 
+   * @param src       first row
+   * @param rowSize   size of a row in bytes
+   * @param rowCount  number of rows
+   * @param columns   requested columns ordered by offset_in_row. dst receives rowCount values.
+   */
+  void deinterleave_rows(const uint8_t* src, const uint64_t rowSize, const uint64_t rowCount, const std::vector<DeinterleaveColumn>& columns)
+  {
+    struct ColumnGroup
+    {
+      size_t first;
+      size_t count; // 1 for single columns, 16/value_size for transposed groups
+    };
+    std::vector<ColumnGroup> groups;
+    for (size_t columnIndex = 0; columnIndex < columns.size();) {
+      const uint64_t valueSize = columns[columnIndex].value_size;
+      size_t runEnd = columnIndex + 1;
+      while (runEnd < columns.size() && columns[runEnd].value_size == valueSize &&
+        columns[runEnd].offset_in_row == columns[runEnd - 1].offset_in_row + valueSize) {
+        ++runEnd;
+      }
+      const size_t groupSize = (1 == valueSize || 2 == valueSize || 4 == valueSize || 8 == valueSize) ? size_t(16 / valueSize) : 0;
+      for (; 0 != groupSize && columnIndex + groupSize <= runEnd; columnIndex += groupSize) {
+        groups.push_back(ColumnGroup{ columnIndex, groupSize });
+      }
+      for (; columnIndex < runEnd; ++columnIndex) {
+        groups.push_back(ColumnGroup{ columnIndex, 1 });
+      }
+    }
+
+    // keep a tile of rows in the second level cache while all groups consume it
+    const uint64_t tileSizeInByte = 256 * 1024;
+    const uint64_t rowsPerTile = std::max<uint64_t>(32, (tileSizeInByte / std::max<uint64_t>(1, rowSize)) & ~uint64_t(31));
+    std::vector<uint8_t*> dsts(16);
+    for (uint64_t rowIndex = 0; rowIndex < rowCount; rowIndex += rowsPerTile) {
+      const uint64_t tileRowCount = std::min(rowsPerTile, rowCount - rowIndex);
+      const uint8_t* tile = src + rowIndex * rowSize;
+      for (const auto& group : groups) {
+        const DeinterleaveColumn& first = columns[group.first];
+        if (1 == group.count) {
+          deinterleave_column(tile + first.offset_in_row, rowSize, tileRowCount, first.value_size, first.dst + rowIndex * first.value_size);
+          continue;
+        }
+        for (size_t i = 0; i < group.count; ++i) {
+          dsts[i] = columns[group.first + i].dst + rowIndex * first.value_size;
+        }
+        switch (first.value_size) {
+        case 1: deinterleave_group<1>(tile + first.offset_in_row, rowSize, tileRowCount, &dsts[0]); break;
+        case 2: deinterleave_group<2>(tile + first.offset_in_row, rowSize, tileRowCount, &dsts[0]); break;
+        case 4: deinterleave_group<4>(tile + first.offset_in_row, rowSize, tileRowCount, &dsts[0]); break;
+        case 8: deinterleave_group<8>(tile + first.offset_in_row, rowSize, tileRowCount, &dsts[0]); break;
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Reduce bytes to the state of a single bit, giving 0 or 1 per byte
+   */
+  void extract_bit_lanes_scalar(uint8_t* data, const uint64_t count, const uint32_t bit)
+  {
+    for (uint64_t index = 0; index < count; ++index) {
+      data[index] = uint8_t((data[index] >> bit) & 1);
+    }
+  }
+
+  /**
+   * @brief Pack bytes into bits, least significant bit first. Each nonzero byte gives a set bit.
+   *        Eight bytes are normalized to 0 or 1 in a word and gathered by a single multiplication.
+   */
+  void pack_nonzero_bits_scalar(const uint8_t* src, const uint64_t count, uint8_t* dst)
+  {
+    uint64_t index = 0;
+    if (!SgmtFileIo::is_big_endian_os()) {
+      const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+      for (; index + 8 <= count; index += 8) {
+        uint64_t word;
+        std::memcpy(&word, src + index, sizeof(word));
+        // the high bit of each byte is set if any bit of the byte is set
+        const uint64_t nonzero = (((word & low7) + low7) | word) & ~low7;
+        dst[index / 8] = uint8_t(((nonzero >> 7) * 0x0102040810204080ULL) >> 56);
+      }
+    }
+    for (; index < count; index += 8) {
+      uint8_t packed = 0;
+      for (uint64_t bit = 0; bit < 8 && index + bit < count; ++bit) {
+        if (0 != src[index + bit]) {
+          packed |= uint8_t(1 << bit);
+        }
+      }
+      dst[index / 8] = packed;
+    }
+  }
+
+#if defined(TDMS_X86)
+  TDMS_TARGET("sse2") void extract_bit_lanes_sse2(uint8_t* data, const uint64_t count, const uint32_t bit)
+  {
+    const __m128i mask = _mm_set1_epi8(char(1 << bit));
+    const __m128i one = _mm_set1_epi8(1);
+    uint64_t index = 0;
+    for (; index + 16 <= count; index += 16) {
+      const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(data + index), _mm_min_epu8(_mm_and_si128(values, mask), one));
+    }
+    extract_bit_lanes_scalar(data + index, count - index, bit);
+  }
+
+  TDMS_TARGET("avx2") void extract_bit_lanes_avx2(uint8_t* data, const uint64_t count, const uint32_t bit)
+  {
+    const __m256i mask = _mm256_set1_epi8(char(1 << bit));
+    const __m256i one = _mm256_set1_epi8(1);
+    uint64_t index = 0;
+    for (; index + 32 <= count; index += 32) {
+      const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + index), _mm256_min_epu8(_mm256_and_si256(values, mask), one));
+    }
+    extract_bit_lanes_scalar(data + index, count - index, bit);
+  }
+
+  TDMS_TARGET("sse2") void pack_nonzero_bits_sse2(const uint8_t* src, const uint64_t count, uint8_t* dst)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t index = 0;
+    for (; index + 16 <= count; index += 16) {
+      const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + index));
+      const uint32_t bits = ~uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(values, zero)));
+      dst[index / 8] = uint8_t(bits);
+      dst[index / 8 + 1] = uint8_t(bits >> 8);
+    }
+    pack_nonzero_bits_scalar(src + index, count - index, dst + index / 8);
+  }
+
+  TDMS_TARGET("avx2") void pack_nonzero_bits_avx2(const uint8_t* src, const uint64_t count, uint8_t* dst)
+  {
+    const __m256i zero = _mm256_setzero_si256();
+    uint64_t index = 0;
+    for (; index + 32 <= count; index += 32) {
+      const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + index));
+      const uint32_t bits = ~uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(values, zero)));
+      for (int byteIndex = 0; byteIndex < 4; ++byteIndex) {
+        dst[index / 8 + byteIndex] = uint8_t(bits >> (8 * byteIndex));
+      }
+    }
+    pack_nonzero_bits_scalar(src + index, count - index, dst + index / 8);
+  }
+#endif
+
+  /**
+   * @brief Replace each byte by the state of one of its bits using the best available kernel.
+   *        Used to decode DAQmx digital lines.
+   * 
+   * @param data   bytes to reduce in place to 0 or 1
+   * @param count  number of bytes
+   * @param bit    index of the bit in the byte, 0 is the least significant
+   */
+  void extract_bit_lanes(uint8_t* data, const uint64_t count, const uint32_t bit)
+  {
+#if defined(TDMS_X86)
+    const SimdLevel simdLevel = get_simd_level();
+    if (simdLevel >= simdLevelAvx2) {
+      extract_bit_lanes_avx2(data, count, bit);
+      return;
+    }
+    if (simdLevel >= simdLevelSse2) {
+      extract_bit_lanes_sse2(data, count, bit);
+      return;
+    }
+#endif
+    extract_bit_lanes_scalar(data, count, bit);
+  }
+
+  /**
+   * @brief Pack bytes into bits using the best available kernel. Bits are filled least
+   *        significant first, unused bits of the last byte are zero.
+   * 
+   * @param src    bytes, each nonzero byte gives a set bit
+   * @param count  number of bytes
+   * @param dst    receives (count + 7) / 8 bytes
+   */
+  void pack_nonzero_bits(const uint8_t* src, const uint64_t count, uint8_t* dst)
+  {
+#if defined(TDMS_X86)
+    const SimdLevel simdLevel = get_simd_level();
+    if (simdLevel >= simdLevelAvx2) {
+      pack_nonzero_bits_avx2(src, count, dst);
+      return;
+    }
+    if (simdLevel >= simdLevelSse2) {
+      pack_nonzero_bits_sse2(src, count, dst);
+      return;
+    }
+#endif
+    pack_nonzero_bits_scalar(src, count, dst);
+  }
+
+  inline uint16_t byte_swap_16(const uint16_t value)
+  {
+    return uint16_t((value >> 8) | (value << 8));
+  }
+
+  inline uint32_t byte_swap_32(const uint32_t value)
+  {
+#if defined(_MSC_VER)
+    return _byteswap_ulong(value);
+#elif defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap32(value);
+#else
+    return (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+#endif
+  }
+
+  inline uint64_t byte_swap_64(const uint64_t value)
+  {
+#if defined(_MSC_VER)
+    return _byteswap_uint64(value);
+#elif defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap64(value);
+#else
+    return (uint64_t(byte_swap_32(uint32_t(value))) << 32) | byte_swap_32(uint32_t(value >> 32));
+#endif
+  }
+
+  /**
+   * @brief Swap endianess of an array of values one by one
+   * 
+   * @param data        values to be swapped in place
+   * @param count       number of values
+   * @param valueSize   size of a single value in bytes
+   */
+  void swap_endianess_scalar(uint8_t* data, const uint64_t count, const size_t valueSize)
+  {
+    switch (valueSize) {
+    case 1:
+      break;
+    case 2:
+      for (uint64_t index = 0; index < count; ++index, data += 2) {
+        uint16_t value;
+        std::memcpy(&value, data, 2);
+        value = byte_swap_16(value);
+        std::memcpy(data, &value, 2);
+      }
+      break;
+    case 4:
+      for (uint64_t index = 0; index < count; ++index, data += 4) {
+        uint32_t value;
+        std::memcpy(&value, data, 4);
+        value = byte_swap_32(value);
+        std::memcpy(data, &value, 4);
+      }
+      break;
+    case 8:
+      for (uint64_t index = 0; index < count; ++index, data += 8) {
+        uint64_t value;
+        std::memcpy(&value, data, 8);
+        value = byte_swap_64(value);
+        std::memcpy(data, &value, 8);
+      }
+      break;
+    case 16:
+      for (uint64_t index = 0; index < count; ++index, data += 16) {
+        uint64_t value[2];
+        std::memcpy(value, data, 16);
+        const uint64_t swapped[2]{ byte_swap_64(value[1]), byte_swap_64(value[0]) };
+        std::memcpy(data, swapped, 16);
+      }
+      break;
+    default:
+      for (uint64_t index = 0; index < count; ++index, data += valueSize) {
+        std::reverse(data, data + valueSize);
+      }
+      break;
+    }
+  }
+
+#if defined(TDMS_X86)
+  /**
+   * @brief Get the byte shuffle mask reversing values of a given size inside 16 bytes
+   */
+  TDMS_TARGET("ssse3") inline __m128i get_swap_shuffle_mask_ssse3(const size_t valueSize)
+  {
+    alignas(16) char mask[16];
+    for (int index = 0; index < 16; ++index) {
+      const int valueStart = index - index % int(valueSize);
+      mask[index] = char(valueStart + int(valueSize) - 1 - index % int(valueSize));
+    }
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+  }
+
+  /**
+   * @brief Swap endianess of values of size 2, 4, 8 or 16 using byte shuffles
+   * 
+   * @return number of values processed. The remaining values need to be handled by the caller.
+   */
+  TDMS_TARGET("ssse3") uint64_t swap_endianess_ssse3(uint8_t* data, const uint64_t count, const size_t valueSize)
+  {
+    const __m128i mask = get_swap_shuffle_mask_ssse3(valueSize);
+    const uint64_t byteCount = count * valueSize;
+    uint64_t offset = 0;
+    for (; offset + 64 <= byteCount; offset += 64) {
+      __m128i* block = reinterpret_cast<__m128i*>(data + offset);
+      _mm_storeu_si128(block + 0, _mm_shuffle_epi8(_mm_loadu_si128(block + 0), mask));
+      _mm_storeu_si128(block + 1, _mm_shuffle_epi8(_mm_loadu_si128(block + 1), mask));
+      _mm_storeu_si128(block + 2, _mm_shuffle_epi8(_mm_loadu_si128(block + 2), mask));
+      _mm_storeu_si128(block + 3, _mm_shuffle_epi8(_mm_loadu_si128(block + 3), mask));
+    }
+    for (; offset + 16 <= byteCount; offset += 16) {
+      __m128i* block = reinterpret_cast<__m128i*>(data + offset);
+      _mm_storeu_si128(block, _mm_shuffle_epi8(_mm_loadu_si128(block), mask));
+    }
+    return offset / valueSize;
+  }
+
+  /**
+   * @brief Same as swap_endianess_ssse3 but shuffling 32 bytes at once
+   */
+  TDMS_TARGET("avx2") uint64_t swap_endianess_avx2(uint8_t* data, const uint64_t count, const size_t valueSize)
+  {
+    const __m128i laneMask = get_swap_shuffle_mask_ssse3(valueSize);
+    const __m256i mask = _mm256_broadcastsi128_si256(laneMask);
+    const uint64_t byteCount = count * valueSize;
+    uint64_t offset = 0;
+    for (; offset + 128 <= byteCount; offset += 128) {
+      __m256i* block = reinterpret_cast<__m256i*>(data + offset);
+      _mm256_storeu_si256(block + 0, _mm256_shuffle_epi8(_mm256_loadu_si256(block + 0), mask));
+      _mm256_storeu_si256(block + 1, _mm256_shuffle_epi8(_mm256_loadu_si256(block + 1), mask));
+      _mm256_storeu_si256(block + 2, _mm256_shuffle_epi8(_mm256_loadu_si256(block + 2), mask));
+      _mm256_storeu_si256(block + 3, _mm256_shuffle_epi8(_mm256_loadu_si256(block + 3), mask));
+    }
+    for (; offset + 32 <= byteCount; offset += 32) {
+      __m256i* block = reinterpret_cast<__m256i*>(data + offset);
+      _mm256_storeu_si256(block, _mm256_shuffle_epi8(_mm256_loadu_si256(block), mask));
+    }
+    for (; offset + 16 <= byteCount; offset += 16) {
+      __m128i* block = reinterpret_cast<__m128i*>(data + offset);
+      _mm_storeu_si128(block, _mm_shuffle_epi8(_mm_loadu_si128(block), laneMask));
+    }
+    return offset / valueSize;
+  }
+#endif
+
+  /**
+   * @brief Swap endianess of an array of values in place. Values of size 2, 4, 8 and 16 are
+   *        swapped using byte shuffle instructions if supported by the cpu.
+   * 
+   * @param data        values to be swapped
+   * @param count       number of values
+   * @param valueSize   size of a single value in bytes
+   */
+  void swap_endianess_bulk(uint8_t* data, const uint64_t count, const size_t valueSize)
+  {
+    uint64_t swapped = 0;
+#if defined(TDMS_X86)
+    if (2 == valueSize || 4 == valueSize || 8 == valueSize || 16 == valueSize) {
+      const SimdLevel simdLevel = get_simd_level();
+      if (simdLevel >= simdLevelAvx2) {
+        swapped = swap_endianess_avx2(data, count, valueSize);
+      }
+      else if (simdLevel >= simdLevelSsse3) {
+        swapped = swap_endianess_ssse3(data, count, valueSize);
+      }
+    }
+#endif
+    swap_endianess_scalar(data + swapped * valueSize, count - swapped, valueSize);
+  }
+
+  /**
+   * @brief Determine if values of a data type can be converted to floating point numbers
+   * 
+   * @param datatype data type to check
+   * @return true for integer, floating point and boolean types
+   */
+  bool is_tdms_data_type_numeric(const tdmsDataType datatype)
+  {
+    switch (datatype) {
+    case tdmsTypeI8:
+    case tdmsTypeI16:
+    case tdmsTypeI32:
+    case tdmsTypeI64:
+    case tdmsTypeU8:
+    case tdmsTypeU16:
+    case tdmsTypeU32:
+    case tdmsTypeU64:
+    case tdmsTypeSingleFloat:
+    case tdmsTypeDoubleFloat:
+    case tdmsTypeSingleFloatWithUnit:
+    case tdmsTypeDoubleFloatWithUnit:
+    case tdmsTypeExtendedFloat:
+    case tdmsTypeExtendedFloatWithUnit:
+    case tdmsTypeBoolean:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  template<size_t N> struct UintOfSize;
+  template<> struct UintOfSize<1> { using type = uint8_t; static type swap(const type value) { return value; } };
+  template<> struct UintOfSize<2> { using type = uint16_t; static type swap(const type value) { return byte_swap_16(value); } };
+  template<> struct UintOfSize<4> { using type = uint32_t; static type swap(const type value) { return byte_swap_32(value); } };
+  template<> struct UintOfSize<8> { using type = uint64_t; static type swap(const type value) { return byte_swap_64(value); } };
+
+  /**
+   * @brief Load a value from an unaligned buffer
+   * 
+   * @tparam T              type of the value
+   * @param src             position of the value
+   * @param swapEndianess   swap the bytes of the value
+   */
+  template<class T> inline T load_value(const uint8_t* src, const bool swapEndianess)
+  {
+    typename UintOfSize<sizeof(T)>::type bits;
+    std::memcpy(&bits, src, sizeof(T));
+    if (swapEndianess) {
+      bits = UintOfSize<sizeof(T)>::swap(bits);
+    }
+    T value;
+    std::memcpy(&value, &bits, sizeof(T));
+    return value;
+  }
+
+  template<class Src, class Dst> void convert_values_scalar(const uint8_t* src, const uint64_t count, const bool swapEndianess, Dst* dst)
+  {
+    for (uint64_t index = 0; index < count; ++index, src += sizeof(Src)) {
+      dst[index] = static_cast<Dst>(load_value<Src>(src, swapEndianess));
+    }
+  }
+
+  /**
+   * @brief Load mantissa and sign/exponent of an extended floating point value from an unaligned buffer
+   *
+   * @param src             position of the 10 byte value
+   * @param swapEndianess   value is stored in the foreign byte order
+   * @param mantissa        64 bit mantissa including the explicit integer bit
+   * @param signExponent    sign bit and 15 bit exponent
+   */
+  inline void load_extended_float(const uint8_t* src, const bool swapEndianess, uint64_t& mantissa, uint16_t& signExponent)
+  {
+    const bool bigEndianLayout = SgmtFileIo::is_big_endian_os() != swapEndianess;
+    mantissa = load_value<uint64_t>(src + (bigEndianLayout ? 2 : 0), swapEndianess);
+    signExponent = load_value<uint16_t>(src + (bigEndianLayout ? 0 : 8), swapEndianess);
+  }
+
+  /**
+   * @brief Load an extended floating point value as long double. Lossless if the long double of
+   *        the platform is the x87 extended format.
+   */
+  inline long double load_extended_float(const uint8_t* src, const bool swapEndianess)
+  {
+#if defined(TDMS_LONG_DOUBLE_IS_EXTENDED)
+    long double value{ 0 };
+    std::memcpy(&value, src, sizeof(float80_));
+    if (swapEndianess) {
+      std::reverse(reinterpret_cast<uint8_t*>(&value), reinterpret_cast<uint8_t*>(&value) + sizeof(float80_));
+    }
+    return value;
+#else
+    uint64_t mantissa{ 0 };
+    uint16_t signExponent{ 0 };
+    load_extended_float(src, swapEndianess, mantissa, signExponent);
+    return extended_float_to_double(mantissa, signExponent);
+#endif
+  }
+
+  void convert_extended_values_scalar(const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst)
+  {
+    for (uint64_t index = 0; index < count; ++index, src += sizeof(float80_)) {
+      uint64_t mantissa;
+      uint16_t signExponent;
+      load_extended_float(src, swapEndianess, mantissa, signExponent);
+      dst[index] = extended_float_to_double(mantissa, signExponent);
+    }
+  }
+
+  /**
+   * @brief Load seconds and fraction of a timestamp from an unaligned buffer
+   *
+   * @param src             position of the 16 byte value
+   * @param swapEndianess   value is stored in the foreign byte order
+   * @param seconds         seconds since 1904-01-01
+   * @param fraction        positive fractions of a second in units of 2^-64
+   */
+  inline void load_timestamp(const uint8_t* src, const bool swapEndianess, int64_t& seconds, uint64_t& fraction)
+  {
+    const bool bigEndianLayout = SgmtFileIo::is_big_endian_os() != swapEndianess;
+    seconds = load_value<int64_t>(src + (bigEndianLayout ? 0 : 8), swapEndianess);
+    fraction = load_value<uint64_t>(src + (bigEndianLayout ? 8 : 0), swapEndianess);
+  }
+
+  void convert_timestamps_scalar(const uint8_t* src, const uint64_t count, const bool swapEndianess, int64_t* dst)
+  {
+    for (uint64_t index = 0; index < count; ++index, src += 16) {
+      int64_t seconds;
+      uint64_t fraction;
+      load_timestamp(src, swapEndianess, seconds, fraction);
+      dst[index] = timestamp_to_unix_nanoseconds(seconds, fraction);
+    }
+  }
+
+  void convert_timestamps_scalar(const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst)
+  {
+    for (uint64_t index = 0; index < count; ++index, src += 16) {
+      int64_t seconds;
+      uint64_t fraction;
+      load_timestamp(src, swapEndianess, seconds, fraction);
+      dst[index] = timestamp_to_unix_seconds(seconds, fraction);
+    }
+  }
+
+#if defined(TDMS_X86)
+  /**
+   * @brief Convert signed 64 bit integers to double. Upper and lower part are placed in the
+   *        mantissa of two doubles with known exponent, so a single rounding addition is needed.
+   */
+  TDMS_TARGET("avx2") inline __m256d int64_to_double_avx2(const __m256i x)
+  {
+    __m256i xH = _mm256_srai_epi32(x, 16);
+    xH = _mm256_blend_epi16(xH, _mm256_setzero_si256(), 0x33);
+    xH = _mm256_add_epi64(xH, _mm256_castpd_si256(_mm256_set1_pd(442721857769029238784.))); // 3*2^67
+    const __m256i xL = _mm256_blend_epi16(x, _mm256_castpd_si256(_mm256_set1_pd(4503599627370496.)), 0x88); // 2^52
+    const __m256d f = _mm256_sub_pd(_mm256_castsi256_pd(xH), _mm256_set1_pd(442726361368656609280.)); // 3*2^67 + 2^52
+    return _mm256_add_pd(f, _mm256_castsi256_pd(xL));
+  }
+
+  /**
+   * @brief Convert unsigned 64 bit integers to double using the same technique as int64_to_double_avx2
+   */
+  TDMS_TARGET("avx2") inline __m256d uint64_to_double_avx2(const __m256i x)
+  {
+    __m256i xH = _mm256_srli_epi64(x, 32);
+    xH = _mm256_or_si256(xH, _mm256_castpd_si256(_mm256_set1_pd(19342813113834066795298816.))); // 2^84
+    const __m256i xL = _mm256_blend_epi16(x, _mm256_castpd_si256(_mm256_set1_pd(4503599627370496.)), 0xcc); // 2^52
+    const __m256d f = _mm256_sub_pd(_mm256_castsi256_pd(xH), _mm256_set1_pd(19342813118337666422669312.)); // 2^84 + 2^52
+    return _mm256_add_pd(f, _mm256_castsi256_pd(xL));
+  }
+
+  /**
+   * @brief Convert values to double using widening conversions. Byte swapping is done by a
+   *        shuffle right after loading the values.
+   * 
+   * @return number of values converted. The remaining values need to be handled by the caller.
+   */
+  template<class Src> uint64_t convert_to_double_avx2(const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst);
+
+  template<> TDMS_TARGET("avx2") uint64_t convert_to_double_avx2<int8_t>(const uint8_t* src, const uint64_t count, const bool, double* dst)
+  {
+    uint64_t index = 0;
+    for (; index + 16 <= count; index += 16) {
+      const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + index));
+      _mm256_storeu_pd(dst + index + 0, _mm256_cvtepi32_pd(_mm_cvtepi8_epi32(x)));
+      _mm256_storeu_pd(dst + index + 4, _mm256_cvtepi32_pd(_mm_cvtepi8_epi32(_mm_srli_si128(x, 4))));
+      _mm256_storeu_pd(dst + index + 8, _mm256_cvtepi32_pd(_mm_cvtepi8_epi32(_mm_srli_si128(x, 8))));
+      _mm256_storeu_pd(dst + index + 12, _mm256_cvtepi32_pd(_mm_cvtepi8_epi32(_mm_srli_si128(x, 12))));
+    }
+    return index;
+  }
+
+  template<> TDMS_TARGET("avx2") uint64_t convert_to_double_avx2<uint8_t>(const uint8_t* src, const uint64_t count, const bool, double* dst)
+  {
+    uint64_t index = 0;
+    for (; index + 16 <= count; index += 16) {
+      const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + index));
+      _mm256_storeu_pd(dst + index + 0, _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(x)));
+      _mm256_storeu_pd(dst + index + 4, _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_srli_si128(x, 4))));
+      _mm256_storeu_pd(dst + index + 8, _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_srli_si128(x, 8))));
+      _mm256_storeu_pd(dst + index + 12, _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_srli_si128(x, 12))));
+    }
+    return index;
+  }
+
+  template<> TDMS_TARGET("avx2") uint64_t convert_to_double_avx2<int16_t>(const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst)
+  {
+    const __m128i mask = get_swap_shuffle_mask_ssse3(2);
+    uint64_t index = 0;
+    for (; index + 8 <= count; index += 8) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + index * 2));
+      if (swapEndianess) {
+        x = _mm_shuffle_epi8(x, mask);
+      }
+      _mm256_storeu_pd(dst + index + 0, _mm256_cvtepi32_pd(_mm_cvtepi16_epi32(x)));
+      _mm256_storeu_pd(dst + index + 4, _mm256_cvtepi32_pd(_mm_cvtepi16_epi32(_mm_srli_si128(x, 8))));
+    }
+    return index;
+  }
+
+  template<> TDMS_TARGET("avx2") uint64_t convert_to_double_avx2<uint16_t>(const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst)
+  {
+    const __m128i mask = get_swap_shuffle_mask_ssse3(2);
+    uint64_t index = 0;
+    for (; index + 8 <= count; index += 8) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + index * 2));
+      if (swapEndianess) {
+        x = _mm_shuffle_epi8(x, mask);
+      }
+      _mm256_storeu_pd(dst + index + 0, _mm256_cvtepi32_pd(_mm_cvtepu16_epi32(x)));
+      _mm256_storeu_pd(dst + index + 4, _mm256_cvtepi32_pd(_mm_cvtepu16_epi32(_mm_srli_si128(x, 8))));
+    }
+    return index;
+  }
+
+  template<> TDMS_TARGET("avx2") uint64_t convert_to_double_avx2<int32_t>(const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst)
+  {
+    const __m128i mask = get_swap_shuffle_mask_ssse3(4);
+    uint64_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + index * 4));
+      if (swapEndianess) {
+        x = _mm_shuffle_epi8(x, mask);
+      }
+      _mm256_storeu_pd(dst + index, _mm256_cvtepi32_pd(x));
+    }
+    return index;
+  }
+
+  template<> TDMS_TARGET("avx2") uint64_t convert_to_double_avx2<uint32_t>(const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst)
+  {
+    const __m128i mask = get_swap_shuffle_mask_ssse3(4);
+    const __m128i signBit = _mm_set1_epi32(int(0x80000000));
+    const __m256d offset = _mm256_set1_pd(2147483648.);
+    uint64_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + index * 4));
+      if (swapEndianess) {
+        x = _mm_shuffle_epi8(x, mask);
+      }
+      // shift the unsigned range into the signed one and back after the conversion
+      _mm256_storeu_pd(dst + index, _mm256_add_pd(_mm256_cvtepi32_pd(_mm_xor_si128(x, signBit)), offset));
+    }
+    return index;
+  }
+
+  template<> TDMS_TARGET("avx2") uint64_t convert_to_double_avx2<int64_t>(const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst)
+  {
+    const __m256i mask = _mm256_broadcastsi128_si256(get_swap_shuffle_mask_ssse3(8));
+    uint64_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + index * 8));
+      if (swapEndianess) {
+        x = _mm256_shuffle_epi8(x, mask);
+      }
+      _mm256_storeu_pd(dst + index, int64_to_double_avx2(x));
+    }
+    return index;
+  }
+
+  template<> TDMS_TARGET("avx2") uint64_t convert_to_double_avx2<uint64_t>(const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst)
+  {
+    const __m256i mask = _mm256_broadcastsi128_si256(get_swap_shuffle_mask_ssse3(8));
+    uint64_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + index * 8));
+      if (swapEndianess) {
+        x = _mm256_shuffle_epi8(x, mask);
+      }
+      _mm256_storeu_pd(dst + index, uint64_to_double_avx2(x));
+    }
+    return index;
+  }
+
+  template<> TDMS_TARGET("avx2") uint64_t convert_to_double_avx2<float>(const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst)
+  {
+    const __m128i mask = get_swap_shuffle_mask_ssse3(4);
+    uint64_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+      __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + index * 4));
+      if (swapEndianess) {
+        x = _mm_shuffle_epi8(x, mask);
+      }
+      _mm256_storeu_pd(dst + index, _mm256_cvtps_pd(_mm_castsi128_ps(x)));
+    }
+    return index;
+  }
+
+  template<> TDMS_TARGET("avx2") uint64_t convert_to_double_avx2<double>(const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst)
+  {
+    const __m256i mask = _mm256_broadcastsi128_si256(get_swap_shuffle_mask_ssse3(8));
+    uint64_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+      __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + index * 8));
+      if (swapEndianess) {
+        x = _mm256_shuffle_epi8(x, mask);
+      }
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + index), x);
+    }
+    return index;
+  }
+
+  TDMS_TARGET("avx2") uint64_t narrow_to_float_avx2(const double* src, const uint64_t count, float* dst)
+  {
+    uint64_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+      _mm_storeu_ps(dst + index, _mm256_cvtpd_ps(_mm256_loadu_pd(src + index)));
+    }
+    return index;
+  }
+
+  /**
+   * @brief Convert extended floating point values to double, four at a time. The mantissas are
+   *        converted by uint64_to_double_avx2 and the exponent is rebiased in the bit pattern.
+   *        Infinity, NaN and zero are selected by masks. Groups containing a subnormal result
+   *        are left to the scalar code.
+   *
+   * @return number of values converted. The remaining values need to be handled by the caller.
+   */
+  TDMS_TARGET("avx2") uint64_t convert_extended_to_double_avx2(const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst)
+  {
+    const __m128i offsets = _mm_setr_epi32(0, 10, 20, 30);
+    const __m256i mask = _mm256_broadcastsi128_si256(get_swap_shuffle_mask_ssse3(8));
+    const __m256i exponentMask = _mm256_set1_epi64x(0x7FFF);
+    const __m256i fractionMask = _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL);
+    const __m256i infinityBits = _mm256_set1_epi64x(0x7FF0000000000000LL);
+    const __m256i quietBit = _mm256_set1_epi64x(0x0008000000000000LL);
+    const __m256i rebias = _mm256_set1_epi64x(16383 + 63);
+    const __m256i maxBiased = _mm256_set1_epi64x(0x7FE);
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i zero = _mm256_setzero_si256();
+
+    uint64_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+      // bytes 0..7 and 2..9 of each value. Little endian they contain the mantissa and the
+      // sign/exponent in the upper 16 bit, big endian the other way round.
+      const long long* base = reinterpret_cast<const long long*>(src + index * sizeof(float80_));
+      __m256i low = _mm256_i32gather_epi64(base, offsets, 1);
+      __m256i high = _mm256_i32gather_epi64(reinterpret_cast<const long long*>(src + index * sizeof(float80_) + 2), offsets, 1);
+      if (swapEndianess) {
+        const __m256i swappedLow = _mm256_shuffle_epi8(high, mask);
+        high = _mm256_shuffle_epi8(low, mask);
+        low = swappedLow;
+      }
+      const __m256i mantissa = low;
+      const __m256i signExponent = _mm256_srli_epi64(high, 48);
+      const __m256i exponent = _mm256_and_si256(signExponent, exponentMask);
+      const __m256i sign = _mm256_slli_epi64(_mm256_srli_epi64(signExponent, 15), 63);
+
+      const __m256i roundedBits = _mm256_castpd_si256(uint64_to_double_avx2(mantissa));
+      const __m256i biased = _mm256_sub_epi64(_mm256_add_epi64(_mm256_srli_epi64(roundedBits, 52), exponent), rebias);
+
+      const __m256i isZero = _mm256_cmpeq_epi64(mantissa, zero);
+      const __m256i isSpecial = _mm256_cmpeq_epi64(exponent, exponentMask);
+      const __m256i isSubnormal = _mm256_andnot_si256(_mm256_or_si256(isZero, isSpecial), _mm256_cmpgt_epi64(one, biased));
+      if (!_mm256_testz_si256(isSubnormal, isSubnormal)) {
+        break;
+      }
+
+      const __m256i infinity = _mm256_or_si256(sign, infinityBits);
+      const __m256i fraction = _mm256_srli_epi64(_mm256_slli_epi64(mantissa, 1), 12);
+      const __m256i nan = _mm256_or_si256(_mm256_or_si256(infinity, quietBit), fraction);
+      const __m256i isNan = _mm256_andnot_si256(_mm256_cmpeq_epi64(_mm256_slli_epi64(mantissa, 1), zero), isSpecial);
+
+      __m256i bits = _mm256_or_si256(_mm256_or_si256(sign, _mm256_slli_epi64(biased, 52)), _mm256_and_si256(roundedBits, fractionMask));
+      bits = _mm256_blendv_epi8(bits, infinity, _mm256_cmpgt_epi64(biased, maxBiased));
+      bits = _mm256_blendv_epi8(bits, sign, isZero);
+      bits = _mm256_blendv_epi8(bits, infinity, isSpecial);
+      bits = _mm256_blendv_epi8(bits, nan, isNan);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + index), bits);
+    }
+    return index;
+  }
+
+  /**
+   * @brief Load four timestamps and split them into seconds and fractions. The values are in the
+   *        order 0, 2, 1, 3 and need to be permuted back after processing.
+   */
+  TDMS_TARGET("avx2") inline void load_timestamps_avx2(const uint8_t* src, const __m256i mask, const bool swapEndianess, __m256i& seconds, __m256i& fraction)
+  {
+    __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+    __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 32));
+    if (swapEndianess) {
+      // reversing all 16 bytes turns the big endian layout into the little endian one
+      first = _mm256_shuffle_epi8(first, mask);
+      second = _mm256_shuffle_epi8(second, mask);
+    }
+    fraction = _mm256_unpacklo_epi64(first, second);
+    seconds = _mm256_unpackhi_epi64(first, second);
+  }
+
+  /**
+   * @brief Convert timestamps to unix nanoseconds, four at a time. AVX2 has no 64 bit multiplication
+   *        so all products are assembled from 32x32 bit multiplications like in timestamp_to_unix_nanoseconds.
+   *
+   * @return number of values converted. The remaining values need to be handled by the caller.
+   */
+  TDMS_TARGET("avx2") uint64_t convert_timestamps_avx2(const uint8_t* src, const uint64_t count, const bool swapEndianess, int64_t* dst)
+  {
+    const __m256i mask = _mm256_broadcastsi128_si256(get_swap_shuffle_mask_ssse3(16));
+    const __m256i nanosecondsPerSecond = _mm256_set1_epi64x(1000000000);
+    const __m256i epochOffset = _mm256_set1_epi64x(tdms_epoch_to_unix_epoch_in_seconds);
+    const __m256i half = _mm256_set1_epi64x(0x80000000LL);
+    uint64_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+      __m256i seconds;
+      __m256i fraction;
+      load_timestamps_avx2(src + index * 16, mask, swapEndianess, seconds, fraction);
+
+      const __m256i fractionHigh = _mm256_mul_epu32(_mm256_srli_epi64(fraction, 32), nanosecondsPerSecond);
+      const __m256i fractionLow = _mm256_mul_epu32(fraction, nanosecondsPerSecond);
+      const __m256i fractionNanoseconds = _mm256_srli_epi64(_mm256_add_epi64(_mm256_add_epi64(fractionHigh, _mm256_srli_epi64(fractionLow, 32)), half), 32);
+
+      // lower 64 bit of the product: lo * 1e9 + ((hi * 1e9) << 32)
+      const __m256i unixSeconds = _mm256_sub_epi64(seconds, epochOffset);
+      const __m256i secondsNanoseconds = _mm256_add_epi64(_mm256_mul_epu32(unixSeconds, nanosecondsPerSecond),
+        _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(unixSeconds, 32), nanosecondsPerSecond), 32));
+
+      const __m256i nanoseconds = _mm256_add_epi64(secondsNanoseconds, fractionNanoseconds);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + index), _mm256_permute4x64_epi64(nanoseconds, 0xD8));
+    }
+    return index;
+  }
+
+  /**
+   * @brief Convert timestamps to unix seconds, four at a time, with the same rounding as timestamp_to_unix_seconds:
+   *        the fraction is truncated to 53 bit and the sum rounded to nearest
+   *
+   * @return number of values converted. The remaining values need to be handled by the caller.
+   */
+  TDMS_TARGET("avx2") uint64_t convert_timestamps_avx2(const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst)
+  {
+    const __m256i mask = _mm256_broadcastsi128_si256(get_swap_shuffle_mask_ssse3(16));
+    const __m256i epochOffset = _mm256_set1_epi64x(tdms_epoch_to_unix_epoch_in_seconds);
+    const __m256d fractionUnit = _mm256_set1_pd(0x1p-53);
+    uint64_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+      __m256i seconds;
+      __m256i fraction;
+      load_timestamps_avx2(src + index * 16, mask, swapEndianess, seconds, fraction);
+      const __m256d unixSeconds = int64_to_double_avx2(_mm256_sub_epi64(seconds, epochOffset));
+      const __m256d fractionSeconds = _mm256_mul_pd(uint64_to_double_avx2(_mm256_srli_epi64(fraction, 11)), fractionUnit);
+      const __m256d value = _mm256_add_pd(unixSeconds, fractionSeconds);
+      _mm256_storeu_pd(dst + index, _mm256_permute4x64_pd(value, 0xD8));
+    }
+    return index;
+  }
+#endif
+
+  /**
+   * @brief Convert timestamps to nanoseconds or seconds since the unix epoch
+   *
+   * @tparam T              int64_t for nanoseconds or double for seconds
+   * @param src             raw timestamps
+   * @param count           number of values
+   * @param swapEndianess   raw values are stored in the foreign byte order
+   * @param dst             destination for count values
+   */
+  template<class T> void convert_timestamps(const uint8_t* src, const uint64_t count, const bool swapEndianess, T* dst)
+  {
+    uint64_t converted = 0;
+#if defined(TDMS_X86)
+    if (get_simd_level() >= simdLevelAvx2) {
+      converted = convert_timestamps_avx2(src, count, swapEndianess, dst);
+    }
+#endif
+    convert_timestamps_scalar(src + converted * 16, count - converted, swapEndianess, dst + converted);
+  }
+
+  void convert_extended_values_to_double(const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst)
+  {
+    uint64_t converted = 0;
+#if defined(TDMS_X86)
+    if (get_simd_level() >= simdLevelAvx2) {
+      while (converted < count) {
+        converted += convert_extended_to_double_avx2(src + converted * sizeof(float80_), count - converted, swapEndianess, dst + converted);
+        // a group with subnormal results or the tail is converted by the scalar code
+        const uint64_t scalarCount = std::min<uint64_t>(4, count - converted);
+        convert_extended_values_scalar(src + converted * sizeof(float80_), scalarCount, swapEndianess, dst + converted);
+        converted += scalarCount;
+      }
+    }
+#endif
+    convert_extended_values_scalar(src + converted * sizeof(float80_), count - converted, swapEndianess, dst + converted);
+  }
+
+  template<class Src> void convert_values_to_double(const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst)
+  {
+    uint64_t converted = 0;
+#if defined(TDMS_X86)
+    if (get_simd_level() >= simdLevelAvx2) {
+      converted = convert_to_double_avx2<Src>(src, count, swapEndianess, dst);
+    }
+#endif
+    convert_values_scalar<Src, double>(src + converted * sizeof(Src), count - converted, swapEndianess, dst + converted);
+  }
+
+  /**
+   * @brief Convert raw values of a numeric tdms data type to double in a single pass. Timestamps
+   *        are converted to seconds since the unix epoch.
+   * 
+   * @param datatype        data type of the raw values
+   * @param src             raw values
+   * @param count           number of values
+   * @param swapEndianess   raw values are stored in the foreign byte order
+   * @param dst             destination for count values
+   * @exception throws std::logic_error if the data type is not numeric
+   */
+  void convert_values_to_floating_point(const tdmsDataType datatype, const uint8_t* src, const uint64_t count, const bool swapEndianess, double* dst)
+  {
+    switch (datatype) {
+    case tdmsTypeI8: convert_values_to_double<int8_t>(src, count, swapEndianess, dst); break;
+    case tdmsTypeI16: convert_values_to_double<int16_t>(src, count, swapEndianess, dst); break;
+    case tdmsTypeI32: convert_values_to_double<int32_t>(src, count, swapEndianess, dst); break;
+    case tdmsTypeI64: convert_values_to_double<int64_t>(src, count, swapEndianess, dst); break;
+    case tdmsTypeU8: convert_values_to_double<uint8_t>(src, count, swapEndianess, dst); break;
+    case tdmsTypeU16: convert_values_to_double<uint16_t>(src, count, swapEndianess, dst); break;
+    case tdmsTypeU32: convert_values_to_double<uint32_t>(src, count, swapEndianess, dst); break;
+    case tdmsTypeU64: convert_values_to_double<uint64_t>(src, count, swapEndianess, dst); break;
+    case tdmsTypeSingleFloat:
+    case tdmsTypeSingleFloatWithUnit: convert_values_to_double<float>(src, count, swapEndianess, dst); break;
+    case tdmsTypeDoubleFloat:
+    case tdmsTypeDoubleFloatWithUnit: convert_values_to_double<double>(src, count, swapEndianess, dst); break;
+    case tdmsTypeExtendedFloat:
+    case tdmsTypeExtendedFloatWithUnit: convert_extended_values_to_double(src, count, swapEndianess, dst); break;
+    case tdmsTypeTimeStamp: convert_timestamps(src, count, swapEndianess, dst); break;
+    case tdmsTypeBoolean:
+      for (uint64_t index = 0; index < count; ++index) {
+        dst[index] = 0 != src[index] ? 1. : 0.;
+      }
+      break;
+    default:
+      throw std::logic_error("data type can not be converted to floating point");
+    }
+  }
+
+  /**
+   * @brief Convert raw values of a numeric tdms data type to float in a single pass
+   * 
+   * @param datatype        data type of the raw values
+   * @param src             raw values
+   * @param count           number of values
+   * @param swapEndianess   raw values are stored in the foreign byte order
+   * @param dst             destination for count values
+   * @exception throws std::logic_error if the data type is not numeric
+   */
+  void convert_values_to_floating_point(const tdmsDataType datatype, const uint8_t* src, const uint64_t count, const bool swapEndianess, float* dst)
+  {
+    // 64 bit integers and extended floats are converted directly to avoid rounding twice
+    switch (datatype) {
+    case tdmsTypeI64: convert_values_scalar<int64_t, float>(src, count, swapEndianess, dst); return;
+    case tdmsTypeU64: convert_values_scalar<uint64_t, float>(src, count, swapEndianess, dst); return;
+    case tdmsTypeExtendedFloat:
+    case tdmsTypeExtendedFloatWithUnit:
+      for (uint64_t index = 0; index < count; ++index) {
+        dst[index] = static_cast<float>(load_extended_float(src + index * sizeof(float80_), swapEndianess));
+      }
+      return;
+    default: break;
+    }
+
+    // all other types except timestamps are exactly representable as double, so narrowing rounds only once
+    const uint64_t blockSize = 1024;
+    double block[blockSize];
+    const size_t valueSize = get_tdms_data_type_byte_size(datatype);
+    for (uint64_t index = 0; index < count; index += blockSize) {
+      const uint64_t blockCount = std::min(blockSize, count - index);
+      convert_values_to_floating_point(datatype, src + index * valueSize, blockCount, swapEndianess, block);
+      uint64_t narrowed = 0;
+#if defined(TDMS_X86)
+      if (get_simd_level() >= simdLevelAvx2) {
+        narrowed = narrow_to_float_avx2(block, blockCount, dst + index);
+      }
+#endif
+      for (; narrowed < blockCount; ++narrowed) {
+        dst[index + narrowed] = static_cast<float>(block[narrowed]);
+      }
+    }
+  }
+
+  /**
+   * @brief Convert raw values of a numeric tdms data type to long double. Extended floats
+   *        are converted lossless if long double is the x87 extended format of the platform.
+   * 
+   * @param datatype        data type of the raw values
+   * @param src             raw values
+   * @param count           number of values
+   * @param swapEndianess   raw values are stored in the foreign byte order
+   * @param dst             destination for count values
+   * @exception throws std::logic_error if the data type is not numeric
+   */
+  void convert_values_to_floating_point(const tdmsDataType datatype, const uint8_t* src, const uint64_t count, const bool swapEndianess, long double* dst)
+  {
+    // unused padding bytes of long double are cleared to get reproducible files
+    std::memset(static_cast<void*>(dst), 0, count * sizeof(long double));
+    switch (datatype) {
+    case tdmsTypeI8: convert_values_scalar<int8_t, long double>(src, count, swapEndianess, dst); break;
+    case tdmsTypeI16: convert_values_scalar<int16_t, long double>(src, count, swapEndianess, dst); break;
+    case tdmsTypeI32: convert_values_scalar<int32_t, long double>(src, count, swapEndianess, dst); break;
+    case tdmsTypeI64: convert_values_scalar<int64_t, long double>(src, count, swapEndianess, dst); break;
+    case tdmsTypeU8: convert_values_scalar<uint8_t, long double>(src, count, swapEndianess, dst); break;
+    case tdmsTypeU16: convert_values_scalar<uint16_t, long double>(src, count, swapEndianess, dst); break;
+    case tdmsTypeU32: convert_values_scalar<uint32_t, long double>(src, count, swapEndianess, dst); break;
+    case tdmsTypeU64: convert_values_scalar<uint64_t, long double>(src, count, swapEndianess, dst); break;
+    case tdmsTypeSingleFloat:
+    case tdmsTypeSingleFloatWithUnit: convert_values_scalar<float, long double>(src, count, swapEndianess, dst); break;
+    case tdmsTypeDoubleFloat:
+    case tdmsTypeDoubleFloatWithUnit: convert_values_scalar<double, long double>(src, count, swapEndianess, dst); break;
+    case tdmsTypeExtendedFloat:
+    case tdmsTypeExtendedFloatWithUnit:
+      for (uint64_t index = 0; index < count; ++index) {
+        dst[index] = load_extended_float(src + index * sizeof(float80_), swapEndianess);
+      }
+      break;
+    case tdmsTypeTimeStamp:
+      for (uint64_t index = 0; index < count; ++index) {
+        int64_t seconds;
+        uint64_t fraction;
+        load_timestamp(src + index * 16, swapEndianess, seconds, fraction);
+        dst[index] = static_cast<long double>(seconds - tdms_epoch_to_unix_epoch_in_seconds) + static_cast<long double>(fraction) * 0x1p-64L;
+      }
+      break;
+    case tdmsTypeBoolean:
+      for (uint64_t index = 0; index < count; ++index) {
+        dst[index] = 0 != src[index] ? 1.L : 0.L;
+      }
+      break;
+    default:
+      throw std::logic_error("data type can not be converted to floating point");
+    }
+  }
+
+  /**
+   * @brief Evaluate a polynomial in place using Horner's method
+   * 
+   * @param coefficients  coefficients starting with the constant term
+   */
+  void evaluate_polynomial_scalar(double* values, const uint64_t count, const std::vector<double>& coefficients)
+  {
+    if (coefficients.empty()) {
+      std::fill(values, values + count, 0.);
+      return;
+    }
+    const size_t degree = coefficients.size() - 1;
+    for (uint64_t index = 0; index < count; ++index) {
+      const double x = values[index];
+      double result = coefficients[degree];
+      for (size_t k = degree; k-- > 0;) {
+        result = result * x + coefficients[k];
+      }
+      values[index] = result;
+    }
+  }
+
+  /**
+   * @brief Evaluate a piecewise polynomial in place. Piece i is used for values up to
+   *        upperBounds[i], the last piece for all values above.
+   */
+  void evaluate_piecewise_polynomial_scalar(double* values, const uint64_t count, const std::vector<double>& upperBounds, const std::vector<std::vector<double>>& pieces)
+  {
+    for (uint64_t index = 0; index < count; ++index) {
+      size_t piece = 0;
+      while (piece < upperBounds.size() && !(values[index] <= upperBounds[piece])) {
+        ++piece;
+      }
+      evaluate_polynomial_scalar(values + index, 1, pieces[piece]);
+    }
+  }
+
+#if defined(TDMS_X86)
+  TDMS_TARGET("sse2") uint64_t evaluate_polynomial_sse2(double* values, const uint64_t count, const std::vector<double>& coefficients)
+  {
+    const size_t degree = coefficients.size() - 1;
+    uint64_t index = 0;
+    for (; index + 2 <= count; index += 2) {
+      const __m128d x = _mm_loadu_pd(values + index);
+      __m128d result = _mm_set1_pd(coefficients[degree]);
+      for (size_t k = degree; k-- > 0;) {
+        result = _mm_add_pd(_mm_mul_pd(result, x), _mm_set1_pd(coefficients[k]));
+      }
+      _mm_storeu_pd(values + index, result);
+    }
+    return index;
+  }
+
+  /**
+   * @brief Evaluate all pieces for four values and blend the results by range. Multiply and add
+   *        are not fused to give the same results as the scalar kernel.
+   */
+  TDMS_TARGET("avx2") uint64_t evaluate_piecewise_polynomial_avx2(double* values, const uint64_t count, const std::vector<double>& upperBounds, const std::vector<std::vector<double>>& pieces)
+  {
+    uint64_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+      const __m256d x = _mm256_loadu_pd(values + index);
+      __m256d selected = _mm256_setzero_pd();
+      for (size_t piece = pieces.size(); piece-- > 0;) {
+        const std::vector<double>& coefficients = pieces[piece];
+        const size_t degree = coefficients.size() - 1;
+        __m256d result = _mm256_set1_pd(coefficients[degree]);
+        for (size_t k = degree; k-- > 0;) {
+          result = _mm256_add_pd(_mm256_mul_pd(result, x), _mm256_set1_pd(coefficients[k]));
+        }
+        if (piece == upperBounds.size()) {
+          selected = result;
+        }
+        else {
+          const __m256d inRange = _mm256_cmp_pd(x, _mm256_set1_pd(upperBounds[piece]), _CMP_LE_OQ);
+          selected = _mm256_blendv_pd(selected, result, inRange);
+        }
+      }
+      _mm256_storeu_pd(values + index, selected);
+    }
+    return index;
+  }
+#endif
+
+  /**
+   * @brief Evaluate a piecewise polynomial in place using the best available kernel
+   */
+  void evaluate_piecewise_polynomial(double* values, const uint64_t count, const std::vector<double>& upperBounds, const std::vector<std::vector<double>>& pieces)
+  {
+    for (const auto& coefficients : pieces) {
+      if (coefficients.empty()) {
+        throw std::logic_error("polynomial without coefficients");
+      }
+    }
+    uint64_t index = 0;
+#if defined(TDMS_X86)
+    const SimdLevel simdLevel = get_simd_level();
+    if (simdLevel >= simdLevelAvx2) {
+      index = evaluate_piecewise_polynomial_avx2(values, count, upperBounds, pieces);
+    }
+    else if (simdLevel >= simdLevelSse2 && 1 == pieces.size()) {
+      index = evaluate_polynomial_sse2(values, count, pieces.front());
+    }
+#endif
+    evaluate_piecewise_polynomial_scalar(values + index, count - index, upperBounds, pieces);
+  }
+
+  /**
+   * @brief Single step of a NI_Scaling chain. Either a piecewise polynomial or an interpolation table.
+   */
+  class ScaleStage
+  {
+  public:
+    /**
+     * @brief Determine if the stage is a single polynomial that can be merged with other polynomials
+     */
+    bool is_polynomial() const
+    {
+      return table_x_.empty() && 1 == pieces_.size() && 1. == input_factor_;
+    }
+
+    /**
+     * @brief Scale values in place
+     */
+    void apply(double* values, const uint64_t count) const
+    {
+      if (!table_x_.empty()) {
+        apply_table(values, count);
+        return;
+      }
+      if (1. != input_factor_) {
+        for (uint64_t index = 0; index < count; ++index) {
+          values[index] *= input_factor_;
+        }
+      }
+      evaluate_piecewise_polynomial(values, count, upper_bounds_, pieces_);
+    }
+
+  private:
+    void apply_table(double* values, const uint64_t count) const
+    {
+      // interpolate linearly, values outside the table are clamped to the first and last entry
+      for (uint64_t index = 0; index < count; ++index) {
+        const double x = values[index];
+        if (x <= table_x_.front()) {
+          values[index] = table_y_.front();
+          continue;
+        }
+        if (x >= table_x_.back()) {
+          values[index] = table_y_.back();
+          continue;
+        }
+        const size_t upper = size_t(std::upper_bound(table_x_.begin(), table_x_.end(), x) - table_x_.begin());
+        const double x0 = table_x_[upper - 1];
+        const double y0 = table_y_[upper - 1];
+        values[index] = y0 + (x - x0) * (table_y_[upper] - y0) / (table_x_[upper] - x0);
+      }
+    }
+
+  public:
+    // applied to the input before evaluating the polynomials
+    double input_factor_{ 1. };
+    // piece i is used up to upper_bounds_[i], the last piece above
+    std::vector<double> upper_bounds_;
+    std::vector<std::vector<double>> pieces_;
+    // ascending pre scaled values and the scaled values of a table scale
+    std::vector<double> table_x_;
+    std::vector<double> table_y_;
+  };
+
+  /**
+   * @brief Multiply a polynomial by a linear factor
+   */
+  std::vector<double> multiply_by_linear(const std::vector<double>& coefficients, const double offset, const double slope)
+  {
+    std::vector<double> product(coefficients.size() + 1, 0.);
+    for (size_t k = 0; k < coefficients.size(); ++k) {
+      product[k] += coefficients[k] * offset;
+      product[k + 1] += coefficients[k] * slope;
+    }
+    return product;
+  }
+
+  /**
+   * @brief Compose two polynomials outer(inner(x)) if one of them is at most linear
+   * 
+   * @return true if composed into result
+   */
+  bool compose_polynomials(const std::vector<double>& outer, const std::vector<double>& inner, std::vector<double>& result)
+  {
+    if (inner.size() <= 2) {
+      const double offset = inner.empty() ? 0. : inner[0];
+      const double slope = inner.size() < 2 ? 0. : inner[1];
+      result.assign(1, outer.empty() ? 0. : outer.back());
+      for (size_t k = outer.size() - std::min<size_t>(outer.size(), 1); k-- > 0;) {
+        result = multiply_by_linear(result, offset, slope);
+        result[0] += outer[k];
+      }
+      return true;
+    }
+    if (outer.size() <= 2) {
+      const double offset = outer.empty() ? 0. : outer[0];
+      const double slope = outer.size() < 2 ? 0. : outer[1];
+      result = inner;
+      for (auto& coefficient : result) {
+        coefficient *= slope;
+      }
+      result[0] += offset;
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Inverse reference functions of the NIST ITS-90 thermocouple tables converting
+   *        millivolts into degree celsius
+   * 
+   * @param thermocoupleType  DAQmx thermocouple type constant
+   * @param stage             receives the upper millivolt bound and coefficients of each range
+   */
+  void set_thermocouple_inverse_function(const uint32_t thermocoupleType, ScaleStage& stage)
+  {
+    switch (thermocoupleType) {
+    case 10072: // J
+      stage.upper_bounds_ = { 0., 42.919 };
+      stage.pieces_ = {
+        { 0., 1.9528268e1, -1.2286185, -1.0752178, -5.9086933e-1, -1.7256713e-1, -2.8131513e-2, -2.3963370e-3, -8.3823321e-5 },
+        { 0., 1.978425e1, -2.001204e-1, 1.036969e-2, -2.549687e-4, 3.585153e-6, -5.344285e-8, 5.099890e-10 },
+        { -3.11358187e3, 3.00543684e2, -9.94773230, 1.70276630e-1, -1.43033468e-3, 4.73886084e-6 } };
+      break;
+    case 10073: // K
+      stage.upper_bounds_ = { 0., 20.644 };
+      stage.pieces_ = {
+        { 0., 2.5173462e1, -1.1662878, -1.0833638, -8.9773540e-1, -3.7342377e-1, -8.6632643e-2, -1.0450598e-2, -5.1920577e-4 },
+        { 0., 2.508355e1, 7.860106e-2, -2.503131e-1, 8.315270e-2, -1.228034e-2, 9.804036e-4, -4.413030e-5, 1.057734e-6, -1.052755e-8 },
+        { -1.318058e2, 4.830222e1, -1.646031, 5.464731e-2, -9.650715e-4, 8.802193e-6, -3.110810e-8 } };
+      break;
+    case 10086: // T
+      stage.upper_bounds_ = { 0. };
+      stage.pieces_ = {
+        { 0., 2.5949192e1, -2.1316967e-1, 7.9018692e-1, 4.2527777e-1, 1.3304473e-1, 2.0241446e-2, 1.2668171e-3 },
+        { 0., 2.592800e1, -7.602961e-1, 4.637791e-2, -2.165394e-3, 6.048144e-5, -7.293422e-7 } };
+      break;
+    default:
+      throw std::logic_error("NI_Scaling thermocouple type not supported: " + std::to_string(thermocoupleType));
+    }
+  }
+
+  /**
+   * @brief Chain of NI_Scaling scales compiled into stages. Consecutive linear and polynomial
+   *        scales are merged into a single polynomial where possible.
+   */
+  class ScalePipeline
+  {
+  public:
+    /**
+     * @brief Number of values scaled at once, small enough to stay in the first level cache
+     *        while all stages process them
+     */
+    static constexpr uint64_t tile_size = 2048;
+
+    /**
+     * @brief Determine if the pipeline leaves the values unchanged
+     */
+    bool empty() const
+    {
+      return stages_.empty();
+    }
+
+    /**
+     * @brief Append a stage and merge it with the previous one if both are polynomials
+     */
+    void add_stage(const ScaleStage& stage)
+    {
+      std::vector<double> composed;
+      if (!stages_.empty() && stages_.back().is_polynomial() && stage.is_polynomial() &&
+        compose_polynomials(stage.pieces_.front(), stages_.back().pieces_.front(), composed)) {
+        stages_.back().pieces_.front() = composed;
+        return;
+      }
+      stages_.push_back(stage);
+    }
+
+    /**
+     * @brief Scale values in place. All stages are applied to a tile of values before moving on.
+     */
+    void apply(double* values, const uint64_t count) const
+    {
+      for (uint64_t index = 0; index < count; index += tile_size) {
+        const uint64_t tileCount = std::min(tile_size, count - index);
+        for (const auto& stage : stages_) {
+          stage.apply(values + index, tileCount);
+        }
+      }
+    }
+
+  private:
+    std::vector<ScaleStage> stages_;
+  };
+
+  /**
+   * @brief Read the NI_Scaling properties of an object and compile them into a pipeline.
+   *        The scale with the highest index is the output, its input source leads back to the raw values.
+   * 
+   * @param properties  properties of a channel, group or file
+   * @return pipeline, empty if the object has no scales or its values are already scaled
+   */
+  ScalePipeline compile_ni_scaling(const ObjectProperties& properties)
+  {
+    const auto find_value = [&properties](const std::string& name) -> const PropertyValue* {
+      const auto property = properties.find(name);
+      return properties.end() == property ? nullptr : &property->second;
+    };
+    const auto get_number = [&find_value](const std::string& name) {
+      const PropertyValue* value = find_value(name);
+      if (nullptr == value) {
+        throw std::logic_error("NI_Scaling property missing: " + name);
+      }
+      return value->number_;
+    };
+    const auto get_numbers = [&get_number](const std::string& prefix) {
+      std::vector<double> numbers(size_t(get_number(prefix + "_Size")));
+      for (size_t index = 0; index < numbers.size(); ++index) {
+        numbers[index] = get_number(prefix + "[" + std::to_string(index) + "]");
+      }
+      return numbers;
+    };
+
+    ScalePipeline pipeline;
+    const PropertyValue* status = find_value("NI_Scaling_Status");
+    if (nullptr != status && "scaled" == status->string_) {
+      return pipeline;
+    }
+
+    uint32_t numberOfScales{ 0 };
+    if (const PropertyValue* value = find_value("NI_Number_Of_Scales")) {
+      numberOfScales = uint32_t(value->number_);
+    }
+    else {
+      for (const auto& property : properties) {
+        if (0 == property.first.compare(0, 9, "NI_Scale[")) {
+          const uint32_t scaleIndex = uint32_t(std::strtoul(property.first.c_str() + 9, nullptr, 10));
+          numberOfScales = std::max(numberOfScales, scaleIndex + 1);
+        }
+      }
+    }
+
+    // follow the input sources from the output back to the raw values
+    std::vector<ScaleStage> stages;
+    const uint32_t rawDataInputSource = 0xFFFFFFFF;
+    for (uint32_t scaleIndex = numberOfScales - 1; 0 != numberOfScales && rawDataInputSource != scaleIndex;) {
+      if (stages.size() >= numberOfScales) {
+        throw std::logic_error("NI_Scaling input sources form a cycle");
+      }
+      const std::string prefix = "NI_Scale[" + std::to_string(scaleIndex) + "]_";
+      // a missing scale must not shorten the chain, its stages would be applied to the wrong values
+      const PropertyValue* scaleType = find_value(prefix + "Scale_Type");
+      if (nullptr == scaleType) {
+        throw std::logic_error("NI_Scaling property missing: " + prefix + "Scale_Type");
+      }
+
+      ScaleStage stage;
+      const std::string typePrefix = prefix + scaleType->string_;
+      if ("Linear" == scaleType->string_) {
+        stage.pieces_.push_back({ get_number(typePrefix + "_Y_Intercept"), get_number(typePrefix + "_Slope") });
+      }
+      else if ("Polynomial" == scaleType->string_) {
+        stage.pieces_.push_back(get_numbers(typePrefix + "_Coefficients"));
+      }
+      else if ("Table" == scaleType->string_) {
+        std::vector<double> preScaled = get_numbers(typePrefix + "_Pre_Scaled_Values");
+        std::vector<double> scaled = get_numbers(typePrefix + "_Scaled_Values");
+        if (preScaled.empty() || preScaled.size() != scaled.size()) {
+          throw std::logic_error("NI_Scaling table sizes do not match");
+        }
+        if (preScaled.front() > preScaled.back()) {
+          std::reverse(preScaled.begin(), preScaled.end());
+          std::reverse(scaled.begin(), scaled.end());
+        }
+        if (!std::is_sorted(preScaled.begin(), preScaled.end())) {
+          throw std::logic_error("NI_Scaling table pre scaled values are not monotonic");
+        }
+        stage.table_x_ = preScaled;
+        stage.table_y_ = scaled;
+      }
+      else if ("Thermocouple" == scaleType->string_) {
+        // direction 0 or a missing direction converts voltage to temperature, 1 the other way round
+        const PropertyValue* direction = find_value(typePrefix + "_Scaling_Direction");
+        if (nullptr != direction && 1. == direction->number_) {
+          throw std::logic_error("NI_Scaling thermocouple scaling from temperature to voltage not supported");
+        }
+        // input in volts, the reference functions expect millivolts and return degree celsius
+        stage.input_factor_ = 1000.;
+        set_thermocouple_inverse_function(uint32_t(get_number(typePrefix + "_Thermocouple_Type")), stage);
+      }
+      else {
+        throw std::logic_error("NI_Scaling scale type not supported: " + scaleType->string_);
+      }
+      stages.push_back(stage);
+
+      const PropertyValue* inputSource = find_value(typePrefix + "_Input_Source");
+      scaleIndex = nullptr == inputSource ? rawDataInputSource : uint32_t(inputSource->number_);
+    }
+
+    for (auto stage = stages.rbegin(); stage != stages.rend(); ++stage) {
+      pipeline.add_stage(*stage);
+    }
+    return pipeline;
+  }
+
+  /**
+   * @brief Get the parent object path of a group or channel
+   * 
+   * @param objPath  object path like /'group'/'channel'
+   * @return /'group' for channels, / for groups and an empty string for the file
+   */
+  std::string get_parent_object_path(const std::string& objPath)
+  {
+    // quotes inside of names are doubled so a component starts at a slash following a closing quote
+    size_t componentStart = std::string::npos;
+    bool inName = false;
+    for (size_t index = 0; index < objPath.size(); ++index) {
+      if ('\'' == objPath[index]) {
+        if (inName && index + 1 < objPath.size() && '\'' == objPath[index + 1]) {
+          ++index;
+          continue;
+        }
+        inName = !inName;
+      }
+      else if ('/' == objPath[index] && !inName) {
+        componentStart = index;
+      }
+    }
+    if (std::string::npos == componentStart || "/" == objPath) {
+      return std::string();
+    }
+    return 0 == componentStart ? std::string("/") : objPath.substr(0, componentStart);
+  }
+
+  /**
+   * @brief Get the scaling of a channel. Channels without scales or scaling status use the
+   *        scales of their group or of the file.
+   * 
+   * @param layout       layout of the tdms file containing the properties
+   * @param channelPath  object path of the channel
+   */
+  ScalePipeline get_channel_scaling(const TdmsFileLayout& layout, const std::string& channelPath)
+  {
+    for (std::string objPath = channelPath; !objPath.empty(); objPath = get_parent_object_path(objPath)) {
+      const ObjectProperties* properties = layout.find_properties(objPath);
+      if (nullptr == properties) {
+        continue;
+      }
+      const bool hasScales = properties->end() != std::find_if(properties->begin(), properties->end(), [](const ObjectProperties::value_type& property) {
+        return 0 == property.first.compare(0, 9, "NI_Scale[") || "NI_Number_Of_Scales" == property.first || "NI_Scaling_Status" == property.first;
+      });
+      if (hasScales) {
+        return compile_ni_scaling(*properties);
+      }
+    }
+    return ScalePipeline();
+  }
+
+  /**
+   * @brief Receives the values of a channel while extracting. Values are delivered in the byte order
+   *        of the operating system unless the sink swaps them itself.
+   */
+  class ChannelSink
+  {
+  public:
+    virtual ~ChannelSink()
+    {
+    }
+
+    /**
+     * @brief Determine if the sink receives values in the byte order of the file to fuse
+     *        swapping with its own processing
+     */
+    virtual bool keeps_file_byte_order() const
+    {
+      return false;
+    }
+
+    /**
+     * @brief Append values of a channel
+     * 
+     * @param channel         layout of the channel in the current segment
+     * @param values          raw values. For strings the offsets followed by the utf8 data of a chunk
+     * @param byteCount       number of bytes in values
+     * @param valueCount      number of values
+     * @param swapEndianess   values are in the foreign byte order of the file. Only set if
+     *                        keeps_file_byte_order returns true.
+     */
+    virtual void append(const SgmtChannelLayout& channel, const uint8_t* values, const uint64_t byteCount, const uint64_t valueCount, const bool swapEndianess) = 0;
+
+    /**
+     * @brief Pass on values held back by the sink after the last append
+     */
+    virtual void flush()
+    {
+    }
+  };
+
+  /**
+   * @brief Collect the values of a channel in memory
+   */
+  class ChannelSinkBuffer : public ChannelSink
+  {
+  public:
+    void append(const SgmtChannelLayout&, const uint8_t* values, const uint64_t byteCount, const uint64_t valueCount, const bool) override
+    {
+      data_.insert(data_.end(), values, values + byteCount);
+      number_of_values_ += valueCount;
+    }
+
+  public:
+    std::vector<uint8_t> data_;
+    uint64_t number_of_values_{ 0LL };
+  };
+
+  /**
+   * @brief Write the values of a channel to a binary file
+   */
+  class ChannelSinkFile : public ChannelSink
+  {
+  public:
+    /**
+     * @brief Create the file the values are written to
+     * 
+     * @tparam PathType  std::string or std::wstring to allow utf16 usage on windows if needed
+     * @param filepath   path of the binary file
+     */
+    template<class PathType> ChannelSinkFile(const PathType& filepath) :
+      ofs_(filepath, std::ios::binary | std::ios::out | std::ios::trunc)
+    {
+      if (!ofs_) {
+        throw std::logic_error("Failed to create file");
+      }
+    }
+
+    void append(const SgmtChannelLayout&, const uint8_t* values, const uint64_t byteCount, const uint64_t valueCount, const bool) override
+    {
+      if (!ofs_.write(reinterpret_cast<const char*>(values), byteCount)) {
+        throw std::logic_error("Failed to write bytes");
+      }
+      number_of_values_ += valueCount;
+    }
+
+    /**
+     * @brief Get the number of values written
+     */
+    uint64_t number_of_values() const
+    {
+      return number_of_values_;
+    }
+
+  private:
+    std::ofstream ofs_;
+    uint64_t number_of_values_{ 0LL };
+  };
+
+  /**
+   * @brief Write the values of a channel to an already opened stream
+   */
+  class ChannelSinkStream : public ChannelSink
+  {
+  public:
+    explicit ChannelSinkStream(std::ostream& os) :
+      os_(os)
+    {
+    }
+
+    void append(const SgmtChannelLayout&, const uint8_t* values, const uint64_t byteCount, const uint64_t valueCount, const bool) override
+    {
+      if (!os_.write(reinterpret_cast<const char*>(values), std::streamsize(byteCount))) {
+        throw std::logic_error("Failed to write bytes");
+      }
+      number_of_values_ += valueCount;
+    }
+
+    /**
+     * @brief Get the number of values written
+     */
+    uint64_t number_of_values() const
+    {
+      return number_of_values_;
+    }
+
+  private:
+    std::ostream& os_;
+    uint64_t number_of_values_{ 0LL };
+  };
+
+  /**
+   * @brief Convert the values of a numeric channel to double, float or long double and pass them to another sink.
+   *        Byte swapping is fused into the conversion.
+   * 
+   * @tparam T  double, float or long double
+   */
+  template<class T> class ChannelSinkFloatingPoint : public ChannelSink
+  {
+  public:
+    /**
+     * @brief Construct a new Channel Sink Floating Point object
+     * 
+     * @param target sink receiving the converted values
+     */
+    explicit ChannelSinkFloatingPoint(ChannelSink& target) : target_(target)
+    {
+    }
+
+    bool keeps_file_byte_order() const override
+    {
+      return true;
+    }
+
+    void append(const SgmtChannelLayout& channel, const uint8_t* values, const uint64_t, const uint64_t valueCount, const bool swapEndianess) override
+    {
+      if (0 == valueCount) {
+        return;
+      }
+      converted_.resize(valueCount);
+      convert_values_to_floating_point(channel.rawInfo_.datatype_, values, valueCount, swapEndianess, &converted_[0]);
+      target_.append(channel, reinterpret_cast<const uint8_t*>(&converted_[0]), valueCount * sizeof(T), valueCount, false);
+    }
+
+  private:
+    ChannelSink& target_;
+    std::vector<T> converted_;
+  };
+
+  /**
+   * @brief Convert the values of a numeric channel to double, apply its NI_Scaling scales and pass
+   *        them to another sink. Conversion and scaling are done tile by tile while the values are
+   *        in the cache.
+   */
+  class ChannelSinkScaled : public ChannelSink
+  {
+  public:
+    /**
+     * @brief Construct a new Channel Sink Scaled object
+     * 
+     * @param target   sink receiving the scaled values
+     * @param scaling  scales of the channel
+     */
+    ChannelSinkScaled(ChannelSink& target, const ScalePipeline& scaling) : target_(target), scaling_(scaling)
+    {
+    }
+
+    bool keeps_file_byte_order() const override
+    {
+      return true;
+    }
+
+    void append(const SgmtChannelLayout& channel, const uint8_t* values, const uint64_t, const uint64_t valueCount, const bool swapEndianess) override
+    {
+      if (0 == valueCount) {
+        return;
+      }
+      const tdmsDataType datatype = channel.rawInfo_.datatype_;
+      const uint64_t valueSize = get_tdms_data_type_byte_size(datatype);
+      converted_.resize(valueCount);
+      for (uint64_t index = 0; index < valueCount; index += ScalePipeline::tile_size) {
+        const uint64_t tileCount = std::min(ScalePipeline::tile_size, valueCount - index);
+        convert_values_to_floating_point(datatype, values + index * valueSize, tileCount, swapEndianess, &converted_[index]);
+        scaling_.apply(&converted_[index], tileCount);
+      }
+      target_.append(channel, reinterpret_cast<const uint8_t*>(&converted_[0]), valueCount * sizeof(double), valueCount, false);
+    }
+
+  private:
+    ChannelSink& target_;
+    const ScalePipeline scaling_;
+    std::vector<double> converted_;
+  };
+
+  /**
+   * @brief Convert the values of a timestamp channel to int64 nanoseconds since the unix epoch
+   *        and pass them to another sink. Byte swapping is fused into the conversion.
+   */
+  class ChannelSinkUnixNanoseconds : public ChannelSink
+  {
+  public:
+    /**
+     * @brief Construct a new Channel Sink Unix Nanoseconds object
+     * 
+     * @param target sink receiving the converted values
+     */
+    explicit ChannelSinkUnixNanoseconds(ChannelSink& target) : target_(target)
+    {
+    }
+
+    bool keeps_file_byte_order() const override
+    {
+      return true;
+    }
+
+    void append(const SgmtChannelLayout& channel, const uint8_t* values, const uint64_t, const uint64_t valueCount, const bool swapEndianess) override
+    {
+      if (tdmsTypeTimeStamp != channel.rawInfo_.datatype_) {
+        throw std::logic_error("data type can not be converted to unix nanoseconds");
+      }
+      if (0 == valueCount) {
+        return;
+      }
+      converted_.resize(valueCount);
+      convert_timestamps(values, valueCount, swapEndianess, &converted_[0]);
+      target_.append(channel, reinterpret_cast<const uint8_t*>(&converted_[0]), valueCount * sizeof(int64_t), valueCount, false);
+    }
+
+  private:
+    ChannelSink& target_;
+    std::vector<int64_t> converted_;
+  };
+
+  /**
+   * @brief Pack the values of a boolean, U8 or DAQmx digital line channel into bits, least
+   *        significant bit first, and pass them to another sink. Each nonzero value gives a set
+   *        bit. Values not filling a byte are held back until the next append or flush.
+   */
+  class ChannelSinkBitPacked : public ChannelSink
+  {
+  public:
+    /**
+     * @brief Construct a new Channel Sink Bit Packed object
+     * 
+     * @param target sink receiving the packed bytes. The value count passed on is the number of bits.
+     */
+    explicit ChannelSinkBitPacked(ChannelSink& target) : target_(target)
+    {
+    }
+
+    void append(const SgmtChannelLayout& channel, const uint8_t* values, const uint64_t, const uint64_t valueCount, const bool) override
+    {
+      const tdmsDataType datatype = channel.rawInfo_.datatype_;
+      if (tdmsTypeBoolean != datatype && tdmsTypeU8 != datatype) {
+        throw std::logic_error("data type can not be packed into bits");
+      }
+      if (0 == valueCount) {
+        return;
+      }
+      channel_ = &channel;
+
+      // complete the byte started by the previous append
+      uint64_t index = 0;
+      for (; 0 != pending_.size() && pending_.size() < 8 && index < valueCount; ++index) {
+        pending_.push_back(values[index]);
+      }
+      if (8 == pending_.size()) {
+        uint8_t packed = 0;
+        pack_nonzero_bits(&pending_[0], 8, &packed);
+        target_.append(channel, &packed, 1, 8, false);
+        pending_.clear();
+      }
+
+      const uint64_t packCount = (valueCount - index) & ~uint64_t(7);
+      if (0 != packCount) {
+        packed_.resize(packCount / 8);
+        pack_nonzero_bits(values + index, packCount, &packed_[0]);
+        target_.append(channel, &packed_[0], packed_.size(), packCount, false);
+        index += packCount;
+      }
+      pending_.insert(pending_.end(), values + index, values + valueCount);
+    }
+
+    void flush() override
+    {
+      if (pending_.empty()) {
+        return;
+      }
+      uint8_t packed = 0;
+      pack_nonzero_bits(&pending_[0], pending_.size(), &packed);
+      target_.append(*channel_, &packed, 1, pending_.size(), false);
+      pending_.clear();
+    }
+
+  private:
+    ChannelSink& target_;
+    const SgmtChannelLayout* channel_{ nullptr };
+    std::vector<uint8_t> pending_;
+    std::vector<uint8_t> packed_;
+  };
+
+  /**
+   * @brief Cumulative number of values of a channel over the segments containing it. Maps a
+   *        sample index to its segment, chunk and position in the chunk in O(log segments).
+   */
+  class ChannelSampleIndex
+  {
+  public:
+    /**
+     * @brief Position of a sample in the raw data
+     */
+    struct Location
+    {
+      const SgmtLayout* segment;
+      const SgmtChannelLayout* channel;
+      uint64_t chunk_index;
+      uint64_t value_index_in_chunk;
+    };
+
+    /**
+     * @brief Build the index of a channel
+     * 
+     * @param layout       layout of the tdms file
+     * @param channelPath  object path of the channel
+     */
+    ChannelSampleIndex(const TdmsFileLayout& layout, const std::string& channelPath)
+    {
+      for (const auto& segment : layout.segments_) {
+        for (const auto& channel : segment.channels_) {
+          if (channel.rawInfo_.objPath_ != channelPath) {
+            continue;
+          }
+          const uint64_t numberOfValues = channel.rawInfo_.number_of_values_ * segment.number_of_chunks_;
+          if (0 != numberOfValues) {
+            entries_.push_back(Entry{ size_, &segment, &channel });
+            size_ += numberOfValues;
+          }
+        }
+      }
+    }
+
+    /**
+     * @brief Get the number of values of the channel
+     */
+    uint64_t size() const
+    {
+      return size_;
+    }
+
+    /**
+     * @brief Find the position of a sample
+     * 
+     * @param sampleIndex  index of the sample in the channel
+     */
+    Location locate(const uint64_t sampleIndex) const
+    {
+      if (sampleIndex >= size_) {
+        throw std::logic_error("Sample index out of range");
+      }
+      const auto entry = std::upper_bound(entries_.begin(), entries_.end(), sampleIndex, [](const uint64_t index, const Entry& rhs) {
+        return index < rhs.first_value_;
+      }) - 1;
+      const uint64_t valuesPerChunk = entry->channel_->rawInfo_.number_of_values_;
+      const uint64_t indexInSegment = sampleIndex - entry->first_value_;
+      return Location{ entry->segment_, entry->channel_, indexInSegment / valuesPerChunk, indexInSegment % valuesPerChunk };
+    }
+
+  private:
+    struct Entry
+    {
+      uint64_t first_value_;
+      const SgmtLayout* segment_;
+      const SgmtChannelLayout* channel_;
+    };
+
+    std::vector<Entry> entries_;
+    uint64_t size_{ 0LL };
+  };
+
+  /**
+   * @brief Extract an arbitrary set of channels in a single sequential sweep over the file.
+   *        Each raw data region is read once in large blocks and scattered into the sinks of the
+   *        requested channels.
+   */
+  class ChannelExtractor
+  {
+  public:
+    /**
+     * @brief Maximum number of bytes read from the file at once
+     */
+    static constexpr uint64_t block_size_in_byte = 16 * 1024 * 1024;
+
+    /**
+     * @brief Construct a new Channel Extractor object
+     * 
+     * @param fileIo  file reader of the tdms file
+     * @param layout  layout of the tdms file
+     */
+    ChannelExtractor(FileIo& fileIo, const TdmsFileLayout& layout) :
+      fileIo_(fileIo), layout_(layout)
+    {
+    }
+
+    /**
+     * @brief Request a channel to be extracted
+     * 
+     * @param channelPath  object path of the channel
+     * @param sink         sink receiving the values of the channel
+     */
+    void add_channel(const std::string& channelPath, ChannelSink& sink)
+    {
+      sinks_[channelPath] = &sink;
+    }
+
+    /**
+     * @brief Sweep the file once and deliver the values of all requested channels
+     */
+    void run()
+    {
+      run(0, layout_.segments_.size());
+    }
+
+    /**
+     * @brief Deliver the values of all requested channels stored in a range of segments
+     * 
+     * @param firstSegment  index of the first segment
+     * @param endSegment    index behind the last segment
+     */
+    void run(const size_t firstSegment, const size_t endSegment)
+    {
+      for (size_t segmentIndex = firstSegment; segmentIndex < endSegment && segmentIndex < layout_.segments_.size(); ++segmentIndex) {
+        extract_segment(layout_.segments_[segmentIndex]);
+      }
+      for (auto& sink : sinks_) {
+        sink.second->flush();
+      }
+    }
+
+    /**
+     * @brief Read a range of samples of a single channel. Only the raw data of the samples is
+     *        read, the segments are found using the sample index of the channel.
+     * 
+     * @param index  sample index of the channel
+     * @param first  index of the first sample
+     * @param end    index behind the last sample
+     * @param sink   sink receiving the values
+     */
+    void extract_range(const ChannelSampleIndex& index, const uint64_t first, const uint64_t end, ChannelSink& sink)
+    {
+      if (first > end || end > index.size()) {
+        throw std::logic_error("Sample range out of range");
+      }
+      for (uint64_t sampleIndex = first; sampleIndex < end;) {
+        const ChannelSampleIndex::Location location = index.locate(sampleIndex);
+        const uint64_t valueCount = std::min(end - sampleIndex, location.channel->rawInfo_.number_of_values_ - location.value_index_in_chunk);
+        extract_chunk_range(*location.segment, SelectedChannel{ location.channel, &sink }, location.chunk_index, location.value_index_in_chunk, valueCount);
+        sampleIndex += valueCount;
+      }
+      sink.flush();
+    }
+
+  private:
+    struct SelectedChannel
+    {
+      const SgmtChannelLayout* channel;
+      ChannelSink* sink;
+    };
+
+    /**
+     * @brief Read consecutive values of a channel inside of a single chunk
+     */
+    void extract_chunk_range(const SgmtLayout& segment, const SelectedChannel& selectedChannel, const uint64_t chunkIndex, const uint64_t firstValue, const uint64_t valueCount)
+    {
+      const SgmtChannelLayout& channel = *selectedChannel.channel;
+      const uint64_t chunkOffset = segment.raw_data_absolute_offset_ + chunkIndex * segment.chunk_size_;
+      if (tdmsTypeString == channel.rawInfo_.datatype_) {
+        throw std::logic_error("Range reads of string channels only supported as text");
+      }
+
+      if (segment.daqmx_) {
+        // read the strides of the raw buffer containing the channel
+        const SgmtChannelLayout decodedChannel = get_decoded_daqmx_channel(channel);
+        const DaqmxScaler& scaler = channel.rawInfo_.daqmx_scalers_.front();
+        const std::vector<uint32_t>& rawDataWidths = channel.rawInfo_.daqmx_raw_data_widths_;
+        uint64_t bufferOffset = chunkOffset;
+        for (uint32_t bufferIndex = 0; bufferIndex < scaler.raw_buffer_index_; ++bufferIndex) {
+          bufferOffset += uint64_t(rawDataWidths[bufferIndex]) * channel.rawInfo_.number_of_values_;
+        }
+        const uint64_t strideSize = rawDataWidths[scaler.raw_buffer_index_];
+        const uint64_t valueSize = decodedChannel.value_size();
+        extract_strided_range(segment, SelectedChannel{ &decodedChannel, selectedChannel.sink }, bufferOffset + firstValue * strideSize,
+          strideSize, scaler.byte_offset_within_stride_, valueSize, valueCount);
+        return;
+      }
+
+      const uint64_t valueSize = channel.value_size();
+      if (segment.interleaved_) {
+        // all chunks of an interleaved segment form one long sequence of rows
+        const uint64_t rowSize = segment.row_size();
+        const uint64_t rowIndex = chunkIndex * channel.rawInfo_.number_of_values_ + firstValue;
+        extract_strided_range(segment, selectedChannel, segment.raw_data_absolute_offset_ + rowIndex * rowSize, rowSize, channel.offset_in_chunk_, valueSize, valueCount);
+        return;
+      }
+
+      const uint64_t valuesPerBlock = std::max<uint64_t>(1, block_size_in_byte / valueSize);
+      for (uint64_t valueIndex = 0; valueIndex < valueCount; valueIndex += valuesPerBlock) {
+        const uint64_t blockValueCount = std::min(valuesPerBlock, valueCount - valueIndex);
+        read_block(chunkOffset + channel.offset_in_chunk_ + (firstValue + valueIndex) * valueSize, blockValueCount * valueSize);
+        deliver(segment, selectedChannel, &buffer_[0], blockValueCount * valueSize, blockValueCount);
+      }
+    }
+
+    /**
+     * @brief Read values stored at a fixed offset in consecutive rows
+     */
+    void extract_strided_range(const SgmtLayout& segment, const SelectedChannel& selectedChannel, const uint64_t firstRowOffset,
+      const uint64_t rowSize, const uint64_t offsetInRow, const uint64_t valueSize, const uint64_t rowCount)
+    {
+      const uint64_t rowsPerBlock = std::max<uint64_t>(1, block_size_in_byte / rowSize);
+      scratch_.resize(1);
+      for (uint64_t rowIndex = 0; rowIndex < rowCount; rowIndex += rowsPerBlock) {
+        const uint64_t blockRowCount = std::min(rowsPerBlock, rowCount - rowIndex);
+        read_block(firstRowOffset + rowIndex * rowSize, blockRowCount * rowSize);
+        std::vector<uint8_t>& values = scratch_.front();
+        values.resize(blockRowCount * valueSize);
+        deinterleave_column(&buffer_[0] + offsetInRow, rowSize, blockRowCount, valueSize, &values[0]);
+        const SgmtChannelLayout& channel = *selectedChannel.channel;
+        if (segment.daqmx_ && channel.rawInfo_.daqmx_scalers_.front().digital_line_) {
+          extract_bit_lanes(&values[0], blockRowCount, channel.rawInfo_.daqmx_scalers_.front().bit_offset_within_byte_);
+        }
+        deliver(segment, selectedChannel, &values[0], values.size(), blockRowCount);
+      }
+    }
+
+    void extract_segment(const SgmtLayout& segment)
+    {
+      if (0 == segment.number_of_chunks_) {
+        return;
+      }
+
+      std::vector<SelectedChannel> selectedChannels;
+      for (const auto& channel : segment.channels_) {
+        const auto sink = sinks_.find(channel.rawInfo_.objPath_);
+        if (sinks_.end() != sink) {
+          selectedChannels.push_back(SelectedChannel{ &channel, sink->second });
+        }
+      }
+      if (selectedChannels.empty()) {
+        return;
+      }
+
+      if (segment.daqmx_) {
+        extract_daqmx(segment, selectedChannels);
+      }
+      else if (segment.interleaved_) {
+        extract_interleaved(segment, selectedChannels);
+      }
+      else {
+        extract_non_interleaved(segment, selectedChannels);
+      }
+    }
+
+    void extract_non_interleaved(const SgmtLayout& segment, const std::vector<SelectedChannel>& selectedChannels)
+    {
+      if (segment.chunk_size_ <= block_size_in_byte) {
+        // read as many complete chunks as fit into a block and scatter them
+        const uint64_t chunksPerBlock = block_size_in_byte / segment.chunk_size_;
+        for (uint64_t chunkIndex = 0; chunkIndex < segment.number_of_chunks_; chunkIndex += chunksPerBlock) {
+          const uint64_t chunkCount = std::min(chunksPerBlock, segment.number_of_chunks_ - chunkIndex);
+          read_block(segment.raw_data_absolute_offset_ + chunkIndex * segment.chunk_size_, chunkCount * segment.chunk_size_);
+          for (uint64_t blockChunkIndex = 0; blockChunkIndex < chunkCount; ++blockChunkIndex) {
+            uint8_t* chunk = &buffer_[blockChunkIndex * segment.chunk_size_];
+            for (const auto& selectedChannel : selectedChannels) {
+              const SgmtChannelLayout& channel = *selectedChannel.channel;
+              deliver(segment, selectedChannel, chunk + channel.offset_in_chunk_, channel.size_in_chunk_, channel.rawInfo_.number_of_values_);
+            }
+          }
+        }
+        return;
+      }
+
+      // huge chunks are read channel by channel in pieces of complete values
+      for (uint64_t chunkIndex = 0; chunkIndex < segment.number_of_chunks_; ++chunkIndex) {
+        const uint64_t chunkOffset = segment.raw_data_absolute_offset_ + chunkIndex * segment.chunk_size_;
+        for (const auto& selectedChannel : selectedChannels) {
+          const SgmtChannelLayout& channel = *selectedChannel.channel;
+          const uint64_t valueSize = channel.value_size();
+          if (0 == valueSize) {
+            read_block(chunkOffset + channel.offset_in_chunk_, channel.size_in_chunk_);
+            deliver(segment, selectedChannel, &buffer_[0], channel.size_in_chunk_, channel.rawInfo_.number_of_values_);
+            continue;
+          }
+
+          const uint64_t valuesPerBlock = std::max<uint64_t>(1, block_size_in_byte / valueSize);
+          for (uint64_t valueIndex = 0; valueIndex < channel.rawInfo_.number_of_values_; valueIndex += valuesPerBlock) {
+            const uint64_t valueCount = std::min(valuesPerBlock, channel.rawInfo_.number_of_values_ - valueIndex);
+            read_block(chunkOffset + channel.offset_in_chunk_ + valueIndex * valueSize, valueCount * valueSize);
+            deliver(segment, selectedChannel, &buffer_[0], valueCount * valueSize, valueCount);
+          }
+        }
+      }
+    }
+
+    void extract_interleaved(const SgmtLayout& segment, const std::vector<SelectedChannel>& selectedChannels)
+    {
+      const uint64_t rowSize = segment.row_size();
+      for (const auto& selectedChannel : selectedChannels) {
+        if (0 == selectedChannel.channel->value_size()) {
+          throw std::logic_error("Variable sized values can not be interleaved");
+        }
+      }
+
+      // all chunks of an interleaved segment form one long sequence of rows
+      const uint64_t rowCount = segment.chunk_size_ * segment.number_of_chunks_ / rowSize;
+      const uint64_t rowsPerBlock = std::max<uint64_t>(1, block_size_in_byte / rowSize);
+      std::vector<DeinterleaveColumn> columns(selectedChannels.size());
+      scratch_.resize(selectedChannels.size());
+      for (uint64_t rowIndex = 0; rowIndex < rowCount; rowIndex += rowsPerBlock) {
+        const uint64_t blockRowCount = std::min(rowsPerBlock, rowCount - rowIndex);
+        read_block(segment.raw_data_absolute_offset_ + rowIndex * rowSize, blockRowCount * rowSize);
+        for (size_t channelIndex = 0; channelIndex < selectedChannels.size(); ++channelIndex) {
+          const SgmtChannelLayout& channel = *selectedChannels[channelIndex].channel;
+          scratch_[channelIndex].resize(blockRowCount * channel.value_size());
+          columns[channelIndex] = DeinterleaveColumn{ channel.offset_in_chunk_, channel.value_size(), &scratch_[channelIndex][0] };
+        }
+        deinterleave_rows(&buffer_[0], rowSize, blockRowCount, columns);
+        for (size_t channelIndex = 0; channelIndex < selectedChannels.size(); ++channelIndex) {
+          deliver(segment, selectedChannels[channelIndex], &scratch_[channelIndex][0], scratch_[channelIndex].size(), blockRowCount);
+        }
+      }
+    }
+
+    void extract_daqmx(const SgmtLayout& segment, const std::vector<SelectedChannel>& selectedChannels)
+    {
+      // all DAQmx channels of a segment share the same raw buffers
+      const SgmtObjectRawInfo& rawInfo = selectedChannels.front().channel->rawInfo_;
+      const std::vector<uint32_t>& rawDataWidths = rawInfo.daqmx_raw_data_widths_;
+      const uint64_t numberOfStrides = rawInfo.number_of_values_;
+
+      // the decoded values get the data type of the scaler
+      std::vector<SgmtChannelLayout> decodedChannels(selectedChannels.size());
+      for (size_t channelIndex = 0; channelIndex < selectedChannels.size(); ++channelIndex) {
+        decodedChannels[channelIndex] = get_decoded_daqmx_channel(*selectedChannels[channelIndex].channel);
+      }
+
+      scratch_.resize(selectedChannels.size());
+      for (uint64_t chunkIndex = 0; chunkIndex < segment.number_of_chunks_; ++chunkIndex) {
+        uint64_t bufferOffset = segment.raw_data_absolute_offset_ + chunkIndex * segment.chunk_size_;
+        for (uint32_t bufferIndex = 0; bufferIndex < rawDataWidths.size(); ++bufferIndex) {
+          const uint64_t strideSize = rawDataWidths[bufferIndex];
+          const uint64_t bufferStart = bufferOffset;
+          bufferOffset += strideSize * numberOfStrides;
+
+          // channels read from this buffer ordered by their offset in the stride
+          std::vector<size_t> channelIndexes;
+          for (size_t channelIndex = 0; channelIndex < decodedChannels.size(); ++channelIndex) {
+            if (bufferIndex == decodedChannels[channelIndex].rawInfo_.daqmx_scalers_.front().raw_buffer_index_) {
+              channelIndexes.push_back(channelIndex);
+            }
+          }
+          if (channelIndexes.empty()) {
+            continue;
+          }
+          std::sort(channelIndexes.begin(), channelIndexes.end(), [&decodedChannels](const size_t lhs, const size_t rhs) {
+            return decodedChannels[lhs].rawInfo_.daqmx_scalers_.front().byte_offset_within_stride_ <
+              decodedChannels[rhs].rawInfo_.daqmx_scalers_.front().byte_offset_within_stride_;
+          });
+
+          // the strides of a raw buffer are rows of interleaved values
+          const uint64_t stridesPerBlock = std::max<uint64_t>(1, block_size_in_byte / strideSize);
+          std::vector<DeinterleaveColumn> columns(channelIndexes.size());
+          for (uint64_t strideIndex = 0; strideIndex < numberOfStrides; strideIndex += stridesPerBlock) {
+            const uint64_t blockStrideCount = std::min(stridesPerBlock, numberOfStrides - strideIndex);
+            read_block(bufferStart + strideIndex * strideSize, blockStrideCount * strideSize);
+            for (size_t columnIndex = 0; columnIndex < channelIndexes.size(); ++columnIndex) {
+              const SgmtChannelLayout& channel = decodedChannels[channelIndexes[columnIndex]];
+              std::vector<uint8_t>& values = scratch_[channelIndexes[columnIndex]];
+              values.resize(blockStrideCount * channel.value_size());
+              columns[columnIndex] = DeinterleaveColumn{ channel.rawInfo_.daqmx_scalers_.front().byte_offset_within_stride_, channel.value_size(), &values[0] };
+            }
+            deinterleave_rows(&buffer_[0], strideSize, blockStrideCount, columns);
+            for (const size_t channelIndex : channelIndexes) {
+              // digital lines were copied as the byte containing their bit
+              const DaqmxScaler& scaler = decodedChannels[channelIndex].rawInfo_.daqmx_scalers_.front();
+              if (scaler.digital_line_) {
+                extract_bit_lanes(&scratch_[channelIndex][0], blockStrideCount, scaler.bit_offset_within_byte_);
+              }
+              const SelectedChannel decodedChannel{ &decodedChannels[channelIndex], selectedChannels[channelIndex].sink };
+              deliver(segment, decodedChannel, &scratch_[channelIndex][0], scratch_[channelIndex].size(), blockStrideCount);
+            }
+          }
+        }
+      }
+    }
+
+    /**
+     * @brief Get the layout of a DAQmx channel with the data type of its decoded values
+     */
+    static SgmtChannelLayout get_decoded_daqmx_channel(const SgmtChannelLayout& channel)
+    {
+      if (tdmsTypeDAQmxRawData != channel.rawInfo_.datatype_) {
+        throw std::logic_error("Mixing DAQmx and other raw data in a segment not supported");
+      }
+      if (channel.rawInfo_.daqmx_scalers_.empty()) {
+        throw std::logic_error("DAQmx channel has no scaler");
+      }
+      const DaqmxScaler& scaler = channel.rawInfo_.daqmx_scalers_.front();
+      const std::vector<uint32_t>& rawDataWidths = channel.rawInfo_.daqmx_raw_data_widths_;
+      SgmtChannelLayout decodedChannel = channel;
+      decodedChannel.rawInfo_.datatype_ = channel.rawInfo_.value_datatype();
+      const uint64_t valueSize = decodedChannel.value_size();
+      if (0 == valueSize) {
+        throw std::logic_error("DAQmx data type not supported");
+      }
+      if (scaler.raw_buffer_index_ >= rawDataWidths.size() || scaler.byte_offset_within_stride_ + valueSize > rawDataWidths[scaler.raw_buffer_index_]) {
+        throw std::logic_error("DAQmx scaler exceeds raw buffer");
+      }
+      return decodedChannel;
+    }
+
+    void read_block(const uint64_t absoluteOffset, const uint64_t byteCount)
+    {
+      if (buffer_.size() < byteCount) {
+        buffer_.resize(byteCount);
+      }
+      fileIo_.seek(absoluteOffset);
+      fileIo_.read_bytes(&buffer_[0], byteCount);
+    }
+
+    void deliver(const SgmtLayout& segment, const SelectedChannel& selectedChannel, uint8_t* values, const uint64_t byteCount, const uint64_t valueCount)
+    {
+      const bool swapEndianess = SgmtFileIo::is_big_endian_os() != segment.big_endian_;
+      if (selectedChannel.sink->keeps_file_byte_order()) {
+        selectedChannel.sink->append(*selectedChannel.channel, values, byteCount, valueCount, swapEndianess);
+        return;
+      }
+      if (swapEndianess) {
+        const tdmsDataType datatype = selectedChannel.channel->rawInfo_.datatype_;
+        const size_t swapSize = get_tdms_data_type_swap_size(datatype);
+        // for strings only the offsets are swapped
+        const uint64_t swapCount = tdmsTypeString == datatype ? valueCount : byteCount / swapSize;
+        swap_endianess_bulk(values, swapCount, swapSize);
+      }
+      selectedChannel.sink->append(*selectedChannel.channel, values, byteCount, valueCount, false);
+    }
+
+  private:
+    FileIo& fileIo_;
+    const TdmsFileLayout& layout_;
+    std::map<std::string, ChannelSink*> sinks_;
+    std::vector<uint8_t> buffer_;
+    std::vector<std::vector<uint8_t>> scratch_;
+  };
+
+  /**
+   * @brief Random access to the values of a string channel without copying them. In each chunk the
+   *        raw data of a string channel is an array of uint32 end offsets followed by the concatenated
+   *        utf8 data, so the i-th value is located by two lookups in the offset array.
+   *        The values point into the MappedFile which has to outlive the view.
+   */
+  class StringChannelView
+  {
+  public:
+    /**
+     * @brief Collect the chunks of a string channel
+     * 
+     * @param file         mapped tdms file
+     * @param layout       layout of the tdms file
+     * @param channelPath  object path of the channel
+     * @exception throws std::logic_error if the channel is not a string channel or exceeds the file
+     */
+    StringChannelView(const MappedFile& file, const TdmsFileLayout& layout, const std::string& channelPath)
+    {
+      for (const auto& segment : layout.segments_) {
+        for (const auto& channel : segment.channels_) {
+          if (channel.rawInfo_.objPath_ != channelPath) {
+            continue;
+          }
+          if (tdmsTypeString != channel.rawInfo_.datatype_) {
+            throw std::logic_error("channel does not contain strings");
+          }
+          if (segment.daqmx_ || segment.interleaved_) {
+            throw std::logic_error("Variable sized values can not be interleaved");
+          }
+          const uint64_t numberOfValues = channel.rawInfo_.number_of_values_;
+          const uint64_t offsetsSize = numberOfValues * sizeof(uint32_t);
+          for (uint64_t chunkIndex = 0; chunkIndex < segment.number_of_chunks_; ++chunkIndex) {
+            const uint64_t chunkOffset = segment.raw_data_absolute_offset_ + chunkIndex * segment.chunk_size_ + channel.offset_in_chunk_;
+            if (chunkOffset + channel.size_in_chunk_ > file.size() || channel.size_in_chunk_ < offsetsSize) {
+              throw std::logic_error("String channel exceeds file size");
+            }
+            const uint8_t* offsets = file.data() + chunkOffset;
+            chunks_.push_back(Chunk{ size_, numberOfValues, offsets, offsets + offsetsSize,
+              channel.size_in_chunk_ - offsetsSize, SgmtFileIo::is_big_endian_os() != segment.big_endian_ });
+            size_ += numberOfValues;
+          }
+        }
+      }
+    }
+
+    /**
+     * @brief Get the number of values of the channel
+     */
+    uint64_t size() const
+    {
+      return size_;
+    }
+
+    /**
+     * @brief Get a value of the channel. The chunk is found by binary search, the value inside
+     *        the chunk in constant time.
+     * 
+     * @param index  index of the value in the channel
+     * @exception throws std::logic_error if index is out of range or the offsets are corrupt
+     */
+    std::string_view value(const uint64_t index) const
+    {
+      if (index >= size_) {
+        throw std::logic_error("string index out of range");
+      }
+      const auto chunk = std::upper_bound(chunks_.begin(), chunks_.end(), index,
+        [](const uint64_t valueIndex, const Chunk& chunk) { return valueIndex < chunk.first_value_; }) - 1;
+      return chunk->value(index - chunk->first_value_);
+    }
+
+    /**
+     * @brief Call a function for all values of the channel in order
+     * 
+     * @tparam Function  callable taking a std::string_view
+     */
+    template<class Function> void for_each(Function function) const
+    {
+      for (const auto& chunk : chunks_) {
+        for (uint64_t index = 0; index < chunk.number_of_values_; ++index) {
+          function(chunk.value(index));
+        }
+      }
+    }
+
+  private:
+    struct Chunk
+    {
+      uint64_t first_value_;
+      uint64_t number_of_values_;
+      const uint8_t* offsets_;
+      const uint8_t* data_;
+      uint64_t data_size_;
+      bool swap_endianess_;
+
+      std::string_view value(const uint64_t index) const
+      {
+        const uint32_t begin = 0 == index ? 0 : load_value<uint32_t>(offsets_ + (index - 1) * sizeof(uint32_t), swap_endianess_);
+        const uint32_t end = load_value<uint32_t>(offsets_ + index * sizeof(uint32_t), swap_endianess_);
+        if (end < begin || end > data_size_) {
+          throw std::logic_error("Invalid string offset");
+        }
+        return std::string_view(reinterpret_cast<const char*>(data_) + begin, end - begin);
+      }
+    };
+
+    std::vector<Chunk> chunks_;
+    uint64_t size_{ 0LL };
+  };
+
+  /**
+   * @brief Write a string value as a line of text. Backslashes, line feeds and carriage returns
+   *        are escaped as \\, \n and \r so every value stays a single line. Runs of other
+   *        characters are written straight from the value.
+   * 
+   * @param os     stream the line is written to
+   * @param value  utf8 value
+   */
+  void write_text_line(std::ostream& os, const std::string_view value)
+  {
+    size_t runStart = 0;
+    for (size_t index = 0; index < value.size(); ++index) {
+      const char ch = value[index];
+      if ('\\' != ch && '\n' != ch && '\r' != ch) {
+        continue;
+      }
+      os.write(value.data() + runStart, std::streamsize(index - runStart));
+      os.put('\\');
+      os.put('\n' == ch ? 'n' : ('\r' == ch ? 'r' : '\\'));
+      runStart = index + 1;
+    }
+    os.write(value.data() + runStart, std::streamsize(value.size() - runStart));
+    os.put('\n');
+  }
+
+  /**
+   * @brief Create a file name from a channel path like /'group'/'channel'. The names are joined
+   *        by dots, letters, digits, '-' and '_' are kept and every other byte, including those
+   *        of multi byte utf8 characters, is percent encoded. Different channels therefore never
+   *        share a file name.
+   * 
+   * @param channelPath object path of the channel
+   * @return file name without extension containing only portable characters
+   */
+  std::string get_channel_file_name(const std::string& channelPath)
+  {
+    static const char hexDigits[] = "0123456789ABCDEF";
+    const auto append = [](std::string& fileName, const char ch) {
+      if (('0' <= ch && ch <= '9') || ('A' <= ch && ch <= 'Z') || ('a' <= ch && ch <= 'z') || '-' == ch || '_' == ch) {
+        fileName += ch;
+      }
+      else {
+        fileName += '%';
+        fileName += hexDigits[static_cast<unsigned char>(ch) >> 4];
+        fileName += hexDigits[static_cast<unsigned char>(ch) & 0xF];
+      }
+    };
+    std::string fileName;
+    bool quoted{ false };
+    for (size_t index = 0; index < channelPath.size(); ++index) {
+      const char ch = channelPath[index];
+      if (quoted) {
+        if ('\'' != ch) {
+          append(fileName, ch);
+        }
+        else if (index + 1 < channelPath.size() && '\'' == channelPath[index + 1]) {
+          // a quote inside a name is doubled
+          append(fileName, ch);
+          ++index;
+        }
+        else {
+          quoted = false;
+        }
+      }
+      else if ('\'' == ch) {
+        quoted = true;
+      }
+      else if ('/' == ch) {
+        if (0 != index) {
+          fileName += '.';
+        }
+      }
+      else {
+        append(fileName, ch);
+      }
+    }
+    return fileName;
+  }
+
+  /**
+   * @brief Data type stored in a tdms file for a C++ type
+   */
+  template<class T> struct TdmsTypeOf;
+  template<> struct TdmsTypeOf<int8_t> { static constexpr tdmsDataType value = tdmsTypeI8; };
+  template<> struct TdmsTypeOf<int16_t> { static constexpr tdmsDataType value = tdmsTypeI16; };
+  template<> struct TdmsTypeOf<int32_t> { static constexpr tdmsDataType value = tdmsTypeI32; };
+  template<> struct TdmsTypeOf<int64_t> { static constexpr tdmsDataType value = tdmsTypeI64; };
+  template<> struct TdmsTypeOf<uint8_t> { static constexpr tdmsDataType value = tdmsTypeU8; };
+  template<> struct TdmsTypeOf<uint16_t> { static constexpr tdmsDataType value = tdmsTypeU16; };
+  template<> struct TdmsTypeOf<uint32_t> { static constexpr tdmsDataType value = tdmsTypeU32; };
+  template<> struct TdmsTypeOf<uint64_t> { static constexpr tdmsDataType value = tdmsTypeU64; };
+  template<> struct TdmsTypeOf<float> { static constexpr tdmsDataType value = tdmsTypeSingleFloat; };
+  template<> struct TdmsTypeOf<double> { static constexpr tdmsDataType value = tdmsTypeDoubleFloat; };
+
+  /**
+   * @brief Contiguous run of values like std::span
+   */
+  template<class T> class ValueSpan
+  {
+  public:
+    ValueSpan(const T* data, const uint64_t size) : data_(data), size_(size)
+    {
+    }
+
+    const T* data() const { return data_; }
+    uint64_t size() const { return size_; }
+    bool empty() const { return 0 == size_; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+    const T& operator[](const uint64_t index) const { return data_[index]; }
+
+  private:
+    const T* data_;
+    uint64_t size_;
+  };
+
+  /**
+   * @brief Typed view of the values of a fixed size channel in a mapped tdms file. The values are
+   *        provided as a sequence of spans, one per run of contiguous values. Spans of
+   *        non-interleaved segments in the byte order of the operating system point straight into
+   *        the mapped file if the values are aligned for T. Misaligned, interleaved, DAQmx and
+   *        foreign byte order data is materialized into a buffer of the caller when the span is
+   *        requested.
+   * 
+   * @tparam T  type matching the stored data type of the channel, uint8_t for booleans and DAQmx
+   *            digital lines
+   */
+  template<class T> class TypedChannelView
+  {
+  public:
+    /**
+     * @brief Collect the runs of values of a channel
+     * 
+     * @param file         mapped tdms file
+     * @param layout       layout of the tdms file
+     * @param channelPath  object path of the channel
+     * @exception throws std::logic_error if the data type does not match T or the data exceeds the file
+     */
+    TypedChannelView(const MappedFile& file, const TdmsFileLayout& layout, const std::string& channelPath)
+    {
+      const bool bigEndianOs = SgmtFileIo::is_big_endian_os();
+      for (const auto& segment : layout.segments_) {
+        for (const auto& channel : segment.channels_) {
+          if (channel.rawInfo_.objPath_ != channelPath) {
+            continue;
+          }
+          const tdmsDataType datatype = channel.rawInfo_.value_datatype();
+          if (TdmsTypeOf<T>::value != datatype && !(std::is_same<T, uint8_t>::value && tdmsTypeBoolean == datatype)) {
+            throw std::logic_error("data type of channel does not match the view");
+          }
+          const uint64_t numberOfValues = channel.rawInfo_.number_of_values_;
+          const bool swapEndianess = sizeof(T) > 1 && bigEndianOs != segment.big_endian_;
+          if (segment.daqmx_) {
+            const DaqmxScaler& scaler = channel.rawInfo_.daqmx_scalers_.front();
+            const std::vector<uint32_t>& rawDataWidths = channel.rawInfo_.daqmx_raw_data_widths_;
+            if (scaler.raw_buffer_index_ >= rawDataWidths.size() || scaler.byte_offset_within_stride_ + sizeof(T) > rawDataWidths[scaler.raw_buffer_index_]) {
+              throw std::logic_error("DAQmx scaler exceeds raw buffer");
+            }
+            uint64_t bufferOffset{ 0LL };
+            for (uint32_t bufferIndex = 0; bufferIndex < scaler.raw_buffer_index_; ++bufferIndex) {
+              bufferOffset += uint64_t(rawDataWidths[bufferIndex]) * numberOfValues;
+            }
+            const uint64_t strideSize = rawDataWidths[scaler.raw_buffer_index_];
+            for (uint64_t chunkIndex = 0; chunkIndex < segment.number_of_chunks_; ++chunkIndex) {
+              const uint64_t offset = segment.raw_data_absolute_offset_ + chunkIndex * segment.chunk_size_ + bufferOffset;
+              add_run(file, segment, Run{ offset + scaler.byte_offset_within_stride_, numberOfValues, strideSize, swapEndianess,
+                scaler.digital_line_ ? int(scaler.bit_offset_within_byte_) : -1, segment.index_ }, offset + strideSize * numberOfValues);
+            }
+          }
+          else if (segment.interleaved_) {
+            // all chunks of an interleaved segment form one long sequence of rows
+            const uint64_t rowSize = segment.row_size();
+            const uint64_t rowCount = numberOfValues * segment.number_of_chunks_;
+            add_run(file, segment, Run{ segment.raw_data_absolute_offset_ + channel.offset_in_chunk_, rowCount, rowSize, swapEndianess, -1, segment.index_ },
+              segment.raw_data_absolute_offset_ + rowCount * rowSize);
+          }
+          else {
+            for (uint64_t chunkIndex = 0; chunkIndex < segment.number_of_chunks_; ++chunkIndex) {
+              const uint64_t offset = segment.raw_data_absolute_offset_ + chunkIndex * segment.chunk_size_ + channel.offset_in_chunk_;
+              add_run(file, segment, Run{ offset, numberOfValues, 0, swapEndianess, -1, segment.index_ }, offset + numberOfValues * sizeof(T));
+            }
+          }
+        }
+      }
+      data_ = file.data();
+    }
+
+    /**
+     * @brief Get the number of values of the channel
+     */
+    uint64_t size() const
+    {
+      return size_;
+    }
+
+    /**
+     * @brief Get the number of spans the values are split into
+     */
+    size_t span_count() const
+    {
+      return runs_.size();
+    }
+
+    /**
+     * @brief Determine if a span points straight into the mapped file. Values not aligned for T
+     *        are copied because accessing them through a const T* is undefined behaviour.
+     */
+    bool is_zero_copy(const size_t spanIndex) const
+    {
+      const Run& run = runs_[spanIndex];
+      const bool aligned = 0 == reinterpret_cast<uintptr_t>(data_ + run.offset_) % alignof(T);
+      return 0 == run.stride_ && !run.swap_endianess_ && run.bit_ < 0 && aligned;
+    }
+
+    /**
+     * @brief Get the index of the segment containing a span
+     */
+    long segment_index(const size_t spanIndex) const
+    {
+      return runs_[spanIndex].segment_index_;
+    }
+
+    /**
+     * @brief Get the values of a span. Does not allocate for zero copy spans.
+     * 
+     * @param spanIndex  index of the span
+     * @param scratch    receives the values if they have to be materialized
+     * @return values pointing into the mapped file or into scratch
+     */
+    ValueSpan<T> span(const size_t spanIndex, std::vector<T>& scratch) const
+    {
+      const Run& run = runs_[spanIndex];
+      const uint8_t* src = data_ + run.offset_;
+      if (is_zero_copy(spanIndex)) {
+        return ValueSpan<T>(reinterpret_cast<const T*>(src), run.number_of_values_);
+      }
+      scratch.resize(run.number_of_values_);
+      uint8_t* dst = reinterpret_cast<uint8_t*>(scratch.data());
+      if (0 == run.stride_) {
+        std::memcpy(dst, src, run.number_of_values_ * sizeof(T));
+      }
+      else {
+        deinterleave_column(src, run.stride_, run.number_of_values_, sizeof(T), dst);
+      }
+      if (run.swap_endianess_) {
+        swap_endianess_bulk(dst, run.number_of_values_, sizeof(T));
+      }
+      if (run.bit_ >= 0) {
+        extract_bit_lanes(dst, run.number_of_values_, uint32_t(run.bit_));
+      }
+      return ValueSpan<T>(scratch.data(), run.number_of_values_);
+    }
+
+    /**
+     * @brief Call a function for all spans of the channel in order
+     * 
+     * @tparam Function  callable taking a ValueSpan<T>
+     */
+    template<class Function> void for_each_span(Function function) const
+    {
+      std::vector<T> scratch;
+      for (size_t spanIndex = 0; spanIndex < runs_.size(); ++spanIndex) {
+        function(span(spanIndex, scratch));
+      }
+    }
+
+  private:
+    struct Run
+    {
+      uint64_t offset_;
+      uint64_t number_of_values_;
+      // distance of consecutive values, 0 if contiguous
+      uint64_t stride_;
+      bool swap_endianess_;
+      // bit of a DAQmx digital line, -1 for all other values
+      int bit_;
+      long segment_index_;
+    };
+
+    void add_run(const MappedFile& file, const SgmtLayout& segment, const Run& run, const uint64_t end)
+    {
+      if (0 == run.number_of_values_) {
+        return;
+      }
+      if (end > file.size() || end > segment.raw_data_absolute_end_) {
+        throw std::logic_error("Raw data exceeds file size");
+      }
+      size_ += run.number_of_values_;
+      // adjacent contiguous runs like the chunks of a single channel segment form one span
+      if (!runs_.empty()) {
+        Run& last = runs_.back();
+        if (0 == last.stride_ && 0 == run.stride_ && last.swap_endianess_ == run.swap_endianess_ && last.bit_ < 0 && run.bit_ < 0 &&
+          last.offset_ + last.number_of_values_ * sizeof(T) == run.offset_) {
+          last.number_of_values_ += run.number_of_values_;
+          return;
+        }
+      }
+      runs_.push_back(run);
+    }
+
+  private:
+    const uint8_t* data_{ nullptr };
+    std::vector<Run> runs_;
+    uint64_t size_{ 0LL };
+  };
+
+  /**
+   * @brief Determine if a channel has a fixed size integer or floating point type that can be
+   *        read through a TypedChannelView
+   */
+  bool has_typed_channel_view(const TdmsFileLayout& layout, const std::string& channelPath)
+  {
+    const SgmtChannelLayout* channel = layout.find_channel(channelPath);
+    if (nullptr == channel) {
+      return false;
+    }
+    switch (channel->rawInfo_.value_datatype()) {
+    case tdmsTypeI8:
+    case tdmsTypeI16:
+    case tdmsTypeI32:
+    case tdmsTypeI64:
+    case tdmsTypeU8:
+    case tdmsTypeBoolean:
+    case tdmsTypeU16:
+    case tdmsTypeU32:
+    case tdmsTypeU64:
+    case tdmsTypeSingleFloat:
+    case tdmsTypeDoubleFloat:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  /**
+   * @brief Create the typed view matching the data type of a channel and pass it to a function
+   * 
+   * @tparam Function  generic callable taking a const TypedChannelView<T>&
+   * @exception throws std::logic_error if the channel has no fixed size integer or floating point type
+   */
+  template<class Function> void visit_typed_channel_view(const MappedFile& file, const TdmsFileLayout& layout, const std::string& channelPath, Function function)
+  {
+    const SgmtChannelLayout* channel = layout.find_channel(channelPath);
+    if (nullptr == channel) {
+      throw std::logic_error("channel not found: " + channelPath);
+    }
+    switch (channel->rawInfo_.value_datatype()) {
+    case tdmsTypeI8: function(TypedChannelView<int8_t>(file, layout, channelPath)); break;
+    case tdmsTypeI16: function(TypedChannelView<int16_t>(file, layout, channelPath)); break;
+    case tdmsTypeI32: function(TypedChannelView<int32_t>(file, layout, channelPath)); break;
+    case tdmsTypeI64: function(TypedChannelView<int64_t>(file, layout, channelPath)); break;
+    case tdmsTypeU8: function(TypedChannelView<uint8_t>(file, layout, channelPath)); break;
+    case tdmsTypeBoolean: function(TypedChannelView<uint8_t>(file, layout, channelPath)); break;
+    case tdmsTypeU16: function(TypedChannelView<uint16_t>(file, layout, channelPath)); break;
+    case tdmsTypeU32: function(TypedChannelView<uint32_t>(file, layout, channelPath)); break;
+    case tdmsTypeU64: function(TypedChannelView<uint64_t>(file, layout, channelPath)); break;
+    case tdmsTypeSingleFloat: function(TypedChannelView<float>(file, layout, channelPath)); break;
+    case tdmsTypeDoubleFloat: function(TypedChannelView<double>(file, layout, channelPath)); break;
+    default:
+      throw std::logic_error("data type has no typed view");
+    }
+  }
+
+  /**
+   * @brief Value format of the files written by extract_tdms_channels
+   */
+  enum ExtractionFormat {
+    extractionFormatRaw,
+    extractionFormatDouble,
+    extractionFormatFloat,
+    extractionFormatLongDouble,
+    extractionFormatUnixNanoseconds,
+    extractionFormatText,
+    extractionFormatBits,
+    extractionFormatScaled
+  };
+
+  /**
+   * @brief Extract channels of a tdms file into binary files containing the values in
+   *        the byte order of the operating system
+   * 
+   * @param tdmsFilePath  path of the tdms file
+   * @param outDir        directory the binary files are written to
+   * @param channelPaths  object paths of the channels to extract. All channels if empty.
+   *                      If converted to floating point all numeric and timestamp channels if empty.
+   *                      If converted to unix nanoseconds all timestamp channels if empty.
+   *                      If written as text all string channels if empty.
+   *                      If packed into bits all boolean, U8 and DAQmx digital line channels if empty.
+   * @param format        keep the stored data type or convert to double, float, long double or
+   *                      unix nanoseconds. Timestamps are converted to seconds since the unix epoch
+   *                      if converted to floating point. String channels can be written as text
+   *                      files containing one value per line. Boolean, U8 and DAQmx digital line
+   *                      channels can be packed into bits. Scaled values are converted to double
+   *                      with the NI_Scaling scales of the channel, its group or the file applied.
+   * @param rangeFirst    index of the first sample extracted of each channel
+   * @param rangeEnd      index behind the last sample extracted of each channel, limited to the
+   *                      number of values of the channel. Only the requested samples are read.
+   * @param useIndexFile  read the meta data from .tdms_index files if available
+   */
+  void extract_tdms_channels(const std::string& tdmsFilePath, const std::string& outDir, std::vector<std::string> channelPaths,
+    const ExtractionFormat format = extractionFormatRaw, const uint64_t rangeFirst = 0, const uint64_t rangeEnd = UINT64_MAX, const bool useIndexFile = true)
+  {
+    const bool rangeRequested = 0 != rangeFirst || UINT64_MAX != rangeEnd;
+    const TdmsFileLayout layout = read_tdms_file_layout(tdmsFilePath, useIndexFile);
+    if (channelPaths.empty()) {
+      for (const auto& channelPath : layout.channel_paths()) {
+        const tdmsDataType datatype = layout.find_channel(channelPath)->rawInfo_.value_datatype();
+        switch (format) {
+        case extractionFormatRaw:
+          channelPaths.push_back(channelPath);
+          break;
+        case extractionFormatUnixNanoseconds:
+          if (tdmsTypeTimeStamp == datatype) {
+            channelPaths.push_back(channelPath);
+          }
+          break;
+        case extractionFormatText:
+          if (tdmsTypeString == datatype) {
+            channelPaths.push_back(channelPath);
+          }
+          break;
+        case extractionFormatBits:
+          if (tdmsTypeBoolean == datatype || tdmsTypeU8 == datatype) {
+            channelPaths.push_back(channelPath);
+          }
+          break;
+        default:
+          if (is_tdms_data_type_numeric(datatype) || tdmsTypeTimeStamp == datatype) {
+            channelPaths.push_back(channelPath);
+          }
+          break;
+        }
+      }
+    }
+
+    std::filesystem::create_directories(outDir);
+
+    if (extractionFormatText == format) {
+      // strings are written straight from the mapped file without copying them
+      const MappedFile mappedFile(tdmsFilePath);
+      for (const auto& channelPath : channelPaths) {
+        const StringChannelView strings(mappedFile, layout, channelPath);
+        const std::string txtFilePath = (std::filesystem::path(outDir) / (get_channel_file_name(channelPath) + ".txt")).string();
+        std::ofstream ofs(txtFilePath, std::ios::binary | std::ios::out | std::ios::trunc);
+        if (!ofs) {
+          throw std::logic_error("Failed to create file");
+        }
+        uint64_t numberOfValues = strings.size();
+        if (rangeRequested) {
+          const uint64_t end = std::min(rangeEnd, strings.size());
+          if (rangeFirst > end) {
+            throw std::logic_error("Sample range out of range");
+          }
+          for (uint64_t index = rangeFirst; index < end; ++index) {
+            write_text_line(ofs, strings.value(index));
+          }
+          numberOfValues = end - rangeFirst;
+        }
+        else {
+          strings.for_each([&ofs](const std::string_view value) {
+            write_text_line(ofs, value);
+          });
+        }
+        if (!ofs) {
+          throw std::logic_error("Failed to write bytes");
+        }
+        std::cout << channelPath << " -> " << txtFilePath << " (" << numberOfValues << " values)" << std::endl;
+      }
+      return;
+    }
+
+    FileIo fileIo(tdmsFilePath);
+    ChannelExtractor extractor(fileIo, layout);
+    std::vector<std::unique_ptr<ChannelSinkFile>> sinks;
+    std::vector<std::unique_ptr<ChannelSink>> converters;
+    std::vector<std::string> binFilePaths;
+    for (const auto& channelPath : channelPaths) {
+      binFilePaths.push_back((std::filesystem::path(outDir) / (get_channel_file_name(channelPath) + ".bin")).string());
+      sinks.emplace_back(new ChannelSinkFile(binFilePaths.back()));
+      switch (format) {
+      case extractionFormatDouble:
+        converters.emplace_back(new ChannelSinkFloatingPoint<double>(*sinks.back()));
+        extractor.add_channel(channelPath, *converters.back());
+        break;
+      case extractionFormatFloat:
+        converters.emplace_back(new ChannelSinkFloatingPoint<float>(*sinks.back()));
+        extractor.add_channel(channelPath, *converters.back());
+        break;
+      case extractionFormatLongDouble:
+        converters.emplace_back(new ChannelSinkFloatingPoint<long double>(*sinks.back()));
+        extractor.add_channel(channelPath, *converters.back());
+        break;
+      case extractionFormatUnixNanoseconds:
+        converters.emplace_back(new ChannelSinkUnixNanoseconds(*sinks.back()));
+        extractor.add_channel(channelPath, *converters.back());
+        break;
+      case extractionFormatBits:
+        converters.emplace_back(new ChannelSinkBitPacked(*sinks.back()));
+        extractor.add_channel(channelPath, *converters.back());
+        break;
+      case extractionFormatScaled:
+        converters.emplace_back(new ChannelSinkScaled(*sinks.back(), get_channel_scaling(layout, channelPath)));
+        extractor.add_channel(channelPath, *converters.back());
+        break;
+      default:
+        extractor.add_channel(channelPath, *sinks.back());
+        break;
+      }
+    }
+    if (rangeRequested) {
+      for (size_t channelIndex = 0; channelIndex < channelPaths.size(); ++channelIndex) {
+        const ChannelSampleIndex index(layout, channelPaths[channelIndex]);
+        ChannelSink& sink = extractionFormatRaw == format ? static_cast<ChannelSink&>(*sinks[channelIndex]) : *converters[channelIndex];
+        extractor.extract_range(index, rangeFirst, std::min(rangeEnd, index.size()), sink);
+      }
+    }
+    else {
+      extractor.run();
+    }
+
+    for (size_t channelIndex = 0; channelIndex < channelPaths.size(); ++channelIndex) {
+      std::cout << channelPaths[channelIndex] << " -> " << binFilePaths[channelIndex] << " (" << sinks[channelIndex]->number_of_values() << " values)" << std::endl;
+    }
+  }
+
+  /**
+   * @brief Multi resolution min/max envelope of a channel. Level 0 summarizes blocks of
+   *        base_block_size values, each higher level blocks of twice the size of the level below.
+   *        The top level contains a single block covering the whole channel.
+   */
+  class MinMaxPyramid
+  {
+  public:
+    /**
+     * @brief Summary of a block of values. NaN values are ignored for min and max.
+     */
+    struct Block
+    {
+      double min_;
+      double max_;
+      double first_;
+      double last_;
+    };
+
+    /**
+     * @brief Construct a new Min Max Pyramid object
+     * 
+     * @param baseBlockSize  number of values summarized by a block of level 0
+     */
+    explicit MinMaxPyramid(const uint64_t baseBlockSize) : base_block_size_(baseBlockSize)
+    {
+      if (0 == baseBlockSize) {
+        throw std::logic_error("Block size must not be zero");
+      }
+    }
+
+    /**
+     * @brief Append values. Blocks of higher levels are merged as soon as both halves are complete.
+     */
+    void append(const double* values, const uint64_t count)
+    {
+      for (uint64_t index = 0; index < count;) {
+        const uint64_t blockCount = std::min(base_block_size_ - current_count_, count - index);
+        const double* blockValues = values + index;
+        if (0 == current_count_) {
+          current_ = Block{ NAN, NAN, blockValues[0], blockValues[0] };
+        }
+        double minValue = current_.min_;
+        double maxValue = current_.max_;
+        for (uint64_t valueIndex = 0; valueIndex < blockCount; ++valueIndex) {
+          minValue = nan_min(minValue, blockValues[valueIndex]);
+          maxValue = nan_max(maxValue, blockValues[valueIndex]);
+        }
+        current_.min_ = minValue;
+        current_.max_ = maxValue;
+        current_.last_ = blockValues[blockCount - 1];
+        current_count_ += blockCount;
+        number_of_values_ += blockCount;
+        index += blockCount;
+        if (base_block_size_ == current_count_) {
+          push_block(0, current_);
+          current_count_ = 0;
+        }
+      }
+    }
+
+    /**
+     * @brief Complete the partial blocks after the last value
+     */
+    void finish()
+    {
+      if (0 != current_count_) {
+        push_block(0, current_);
+        current_count_ = 0;
+      }
+      // an unpaired last block is promoted to the next level on its own
+      for (size_t level = 0; level < levels_.size(); ++level) {
+        if (levels_[level].size() > 1 && 1 == levels_[level].size() % 2) {
+          push_block(level + 1, levels_[level].back());
+        }
+      }
+    }
+
+    uint64_t base_block_size() const { return base_block_size_; }
+    uint64_t number_of_values() const { return number_of_values_; }
+    const std::vector<std::vector<Block>>& levels() const { return levels_; }
+
+  private:
+    static double nan_min(const double lhs, const double rhs)
+    {
+      return std::isnan(lhs) || rhs < lhs ? rhs : lhs;
+    }
+
+    static double nan_max(const double lhs, const double rhs)
+    {
+      return std::isnan(lhs) || rhs > lhs ? rhs : lhs;
+    }
+
+    void push_block(const size_t level, const Block& block)
+    {
+      if (levels_.size() == level) {
+        levels_.emplace_back();
+      }
+      std::vector<Block>& blocks = levels_[level];
+      blocks.push_back(block);
+      if (0 == blocks.size() % 2) {
+        const Block& lhs = blocks[blocks.size() - 2];
+        const Block& rhs = blocks.back();
+        push_block(level + 1, Block{ nan_min(lhs.min_, rhs.min_), nan_max(lhs.max_, rhs.max_), lhs.first_, rhs.last_ });
+      }
+    }
+
+  private:
+    uint64_t base_block_size_;
+    uint64_t number_of_values_{ 0LL };
+    Block current_{ NAN, NAN, NAN, NAN };
+    uint64_t current_count_{ 0LL };
+    std::vector<std::vector<Block>> levels_;
+  };
+
+  /**
+   * @brief Feed the double values of a channel into a min/max pyramid
+   */
+  class ChannelSinkPyramid : public ChannelSink
+  {
+  public:
+    explicit ChannelSinkPyramid(MinMaxPyramid& pyramid) : pyramid_(pyramid)
+    {
+    }
+
+    void append(const SgmtChannelLayout&, const uint8_t* values, const uint64_t, const uint64_t valueCount, const bool) override
+    {
+      pyramid_.append(reinterpret_cast<const double*>(values), valueCount);
+    }
+
+  private:
+    MinMaxPyramid& pyramid_;
+  };
+
+  /**
+   * @brief Build min/max pyramids of channels and store them in a sidecar file. The sidecar is
+   *        written in the byte order of the operating system:
+   * 
+   *        char[4]   "TDSp"
+   *        uint32    version 1
+   *        uint64    segment table key of the tdms file, see TdmsFileLayout::segment_table_key
+   *        uint64    size of the tdms file
+   *        uint64    number of values summarized by a block of level 0
+   *        uint32    number of channels, followed by each channel:
+   *          uint32 + utf8   object path
+   *          uint64          number of values
+   *          uint32          number of levels
+   *          uint64[levels]  number of blocks of each level
+   *          blocks of all levels, level 0 first, each as double min, max, first, last
+   * 
+   * @param tdmsFilePath     path of the tdms file
+   * @param pyramidFilePath  path of the sidecar file
+   * @param channelPaths     object paths of the channels. All numeric and timestamp channels if empty.
+   * @param baseBlockSize    number of values summarized by a block of level 0, a power of two
+   * @param useIndexFile     read the meta data from .tdms_index files if available
+   */
+  void build_min_max_pyramids(const std::string& tdmsFilePath, const std::string& pyramidFilePath, std::vector<std::string> channelPaths, const uint64_t baseBlockSize,
+    const bool useIndexFile = true)
+  {
+    if (0 == baseBlockSize || 0 != (baseBlockSize & (baseBlockSize - 1))) {
+      throw std::logic_error("Block size must be a power of two");
+    }
+    const TdmsFileLayout layout = read_tdms_file_layout(tdmsFilePath, useIndexFile);
+    if (channelPaths.empty()) {
+      for (const auto& channelPath : layout.channel_paths()) {
+        const tdmsDataType datatype = layout.find_channel(channelPath)->rawInfo_.value_datatype();
+        if (is_tdms_data_type_numeric(datatype) || tdmsTypeTimeStamp == datatype) {
+          channelPaths.push_back(channelPath);
+        }
+      }
+    }
+
+    // fixed size values are converted straight from the mapped file, timestamps and extended
+    // floats are read by the extractor in a single sweep over the file
+    const MappedFile mappedFile(tdmsFilePath);
+    FileIo fileIo(tdmsFilePath);
+    ChannelExtractor extractor(fileIo, layout);
+    std::vector<std::unique_ptr<MinMaxPyramid>> pyramids;
+    std::vector<std::unique_ptr<ChannelSink>> sinks;
+    for (const auto& channelPath : channelPaths) {
+      pyramids.emplace_back(new MinMaxPyramid(baseBlockSize));
+      MinMaxPyramid& pyramid = *pyramids.back();
+      if (has_typed_channel_view(layout, channelPath)) {
+        visit_typed_channel_view(mappedFile, layout, channelPath, [&pyramid](const auto& view) {
+          std::vector<double> tile;
+          view.for_each_span([&pyramid, &tile](const auto& values) {
+            for (uint64_t first = 0; first < values.size(); first += ScalePipeline::tile_size) {
+              const uint64_t count = std::min(ScalePipeline::tile_size, values.size() - first);
+              tile.assign(values.begin() + first, values.begin() + first + count);
+              pyramid.append(tile.data(), count);
+            }
+          });
+        });
+        continue;
+      }
+      sinks.emplace_back(new ChannelSinkPyramid(pyramid));
+      sinks.emplace_back(new ChannelSinkFloatingPoint<double>(*sinks.back()));
+      extractor.add_channel(channelPath, *sinks.back());
+    }
+    extractor.run();
+
+    std::ofstream ofs(pyramidFilePath, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!ofs) {
+      throw std::logic_error("Failed to create file");
+    }
+    const auto write_value = [&ofs](const auto& value) {
+      ofs.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    ofs.write("TDSp", 4);
+    write_value(uint32_t(1));
+    write_value(layout.segment_table_key());
+    write_value(layout.size_);
+    write_value(baseBlockSize);
+    write_value(uint32_t(channelPaths.size()));
+    for (size_t channelIndex = 0; channelIndex < channelPaths.size(); ++channelIndex) {
+      MinMaxPyramid& pyramid = *pyramids[channelIndex];
+      pyramid.finish();
+      write_value(uint32_t(channelPaths[channelIndex].size()));
+      ofs.write(channelPaths[channelIndex].data(), channelPaths[channelIndex].size());
+      write_value(pyramid.number_of_values());
+      write_value(uint32_t(pyramid.levels().size()));
+      for (const auto& blocks : pyramid.levels()) {
+        write_value(uint64_t(blocks.size()));
+      }
+      for (const auto& blocks : pyramid.levels()) {
+        ofs.write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(MinMaxPyramid::Block));
+      }
+      std::cout << channelPaths[channelIndex] << " -> " << pyramidFilePath << " (" << pyramid.number_of_values() << " values, "
+        << pyramid.levels().size() << " levels)" << std::endl;
+    }
+    if (!ofs) {
+      throw std::logic_error("Failed to write bytes");
+    }
+  }
+
+  /**
+   * @brief Mergeable statistics of the values of a channel. Mean and variance are accumulated
+   *        per tile with a two pass algorithm and combined using the parallel update of Chan et al.,
+   *        so partial results of consecutive parts of a channel can be merged in any grouping.
+   *        NaN and infinite values are counted but excluded from min, max, mean and variance.
+   */
+  class ChannelStatistics
+  {
+  public:
+    /**
+     * @brief Number of values accumulated at once
+     */
+    static constexpr uint64_t tile_size = 4096;
+
+    /**
+     * @brief Add values following all values added before
+     */
+    void add(const double* values, const uint64_t count)
+    {
+      for (uint64_t index = 0; index < count; index += tile_size) {
+        const uint64_t tileCount = std::min(tile_size, count - index);
+        const double* tile = values + index;
+        ChannelStatistics tileStatistics;
+        tileStatistics.number_of_values_ = tileCount;
+        tileStatistics.first_ = tile[0];
+        tileStatistics.last_ = tile[tileCount - 1];
+        double sum{ 0. };
+        for (uint64_t valueIndex = 0; valueIndex < tileCount; ++valueIndex) {
+          const double value = tile[valueIndex];
+          if (std::isnan(value)) {
+            ++tileStatistics.nan_count_;
+          }
+          else if (std::isinf(value)) {
+            ++tileStatistics.inf_count_;
+          }
+          else {
+            ++tileStatistics.finite_count_;
+            sum += value;
+            tileStatistics.min_ = std::min(tileStatistics.min_, value);
+            tileStatistics.max_ = std::max(tileStatistics.max_, value);
+          }
+        }
+        if (0 != tileStatistics.finite_count_) {
+          const double mean = sum / double(tileStatistics.finite_count_);
+          double m2{ 0. };
+          for (uint64_t valueIndex = 0; valueIndex < tileCount; ++valueIndex) {
+            const double value = tile[valueIndex];
+            if (std::isfinite(value)) {
+              m2 += (value - mean) * (value - mean);
+            }
+          }
+          tileStatistics.mean_ = mean;
+          tileStatistics.m2_ = m2;
+        }
+        merge(tileStatistics);
+      }
+    }
+
+    /**
+     * @brief Merge the statistics of the values following the values of this object
+     */
+    void merge(const ChannelStatistics& following)
+    {
+      if (0 == following.number_of_values_) {
+        return;
+      }
+      if (0 == number_of_values_) {
+        first_ = following.first_;
+      }
+      last_ = following.last_;
+      number_of_values_ += following.number_of_values_;
+      nan_count_ += following.nan_count_;
+      inf_count_ += following.inf_count_;
+      min_ = std::min(min_, following.min_);
+      max_ = std::max(max_, following.max_);
+      if (0 != following.finite_count_) {
+        const double count = double(finite_count_);
+        const double followingCount = double(following.finite_count_);
+        const double totalCount = count + followingCount;
+        const double delta = following.mean_ - mean_;
+        mean_ += delta * followingCount / totalCount;
+        m2_ += following.m2_ + delta * delta * count * followingCount / totalCount;
+        finite_count_ += following.finite_count_;
+      }
+    }
+
+    /**
+     * @brief Get the population variance of the finite values
+     */
+    double variance() const
+    {
+      return 0 == finite_count_ ? NAN : m2_ / double(finite_count_);
+    }
+
+  public:
+    uint64_t number_of_values_{ 0LL };
+    uint64_t finite_count_{ 0LL };
+    uint64_t nan_count_{ 0LL };
+    uint64_t inf_count_{ 0LL };
+    double min_{ std::numeric_limits<double>::infinity() };
+    double max_{ -std::numeric_limits<double>::infinity() };
+    double mean_{ 0. };
+    double m2_{ 0. };
+    double first_{ NAN };
+    double last_{ NAN };
+  };
+
+  /**
+   * @brief Accumulate the double values of a channel into statistics
+   */
+  class ChannelSinkStatistics : public ChannelSink
+  {
+  public:
+    explicit ChannelSinkStatistics(ChannelStatistics& statistics) : statistics_(statistics)
+    {
+    }
+
+    void append(const SgmtChannelLayout&, const uint8_t* values, const uint64_t, const uint64_t valueCount, const bool) override
+    {
+      statistics_.add(reinterpret_cast<const double*>(values), valueCount);
+    }
+
+  private:
+    ChannelStatistics& statistics_;
+  };
+
+  /**
+   * @brief Compute statistics of channels in parallel. The segments are split into consecutive
+   *        ranges of a fixed number of segments, worker threads take ranges from a shared counter
+   *        and extract them with their own file reader. The partial results are merged in file
+   *        order, so the floating point results do not depend on the number of threads.
+   * 
+   * @param tdmsFilePath  path of the tdms file
+   * @param layout        layout of the tdms file
+   * @param channelPaths  object paths of numeric or timestamp channels
+   * @param threadCount   number of worker threads
+   * @return statistics in the order of channelPaths
+   */
+  std::vector<ChannelStatistics> compute_channel_statistics(const std::string& tdmsFilePath, const TdmsFileLayout& layout,
+    const std::vector<std::string>& channelPaths, const unsigned threadCount)
+  {
+    // the ranges only depend on the segments, many small ranges balance segments of different size
+    const size_t segmentsPerRange = 16;
+    const size_t segmentCount = layout.segments_.size();
+    std::vector<size_t> rangeEnds;
+    for (size_t rangeEnd = segmentsPerRange; rangeEnd < segmentCount; rangeEnd += segmentsPerRange) {
+      rangeEnds.push_back(rangeEnd);
+    }
+    rangeEnds.push_back(segmentCount);
+
+    std::vector<std::vector<ChannelStatistics>> partialStatistics(rangeEnds.size(), std::vector<ChannelStatistics>(channelPaths.size()));
+    std::atomic<size_t> nextRange{ 0 };
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    const auto worker = [&]() {
+      try {
+        FileIo fileIo(tdmsFilePath);
+        for (size_t rangeIndex = nextRange++; rangeIndex < rangeEnds.size(); rangeIndex = nextRange++) {
+          ChannelExtractor extractor(fileIo, layout);
+          std::vector<std::unique_ptr<ChannelSink>> sinks;
+          for (size_t channelIndex = 0; channelIndex < channelPaths.size(); ++channelIndex) {
+            sinks.emplace_back(new ChannelSinkStatistics(partialStatistics[rangeIndex][channelIndex]));
+            sinks.emplace_back(new ChannelSinkFloatingPoint<double>(*sinks.back()));
+            extractor.add_channel(channelPaths[channelIndex], *sinks.back());
+          }
+          extractor.run(0 == rangeIndex ? 0 : rangeEnds[rangeIndex - 1], rangeEnds[rangeIndex]);
+        }
+      }
+      catch (...) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        error = std::current_exception();
+        nextRange = rangeEnds.size();
+      }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned threadIndex = 1; threadIndex < std::min<size_t>(std::max(1U, threadCount), rangeEnds.size()); ++threadIndex) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+
+    std::vector<ChannelStatistics> statistics(channelPaths.size());
+    for (const auto& rangeStatistics : partialStatistics) {
+      for (size_t channelIndex = 0; channelIndex < channelPaths.size(); ++channelIndex) {
+        statistics[channelIndex].merge(rangeStatistics[channelIndex]);
+      }
+    }
+    return statistics;
+  }
+
+  /**
+   * @brief Format a double without losing precision
+   */
+  std::string format_double(const double value)
+  {
+    std::ostringstream ost;
+    ost.imbue(std::locale("C"));
+    ost.precision(17);
+    ost << value;
+    return ost.str();
+  }
+
+  /**
+   * @brief Log path, data type and statistics of a channel
+   */
+  template<class Logger> void log_channel_statistics(Logger& sl, const std::string& channelPath, const tdmsDataType datatype, const ChannelStatistics& channelStatistics)
+  {
+    const bool hasFiniteValues = 0 != channelStatistics.finite_count_;
+    sl.add("path", channelPath);
+    sl.add("data_type_string", get_tdms_data_type_as_string(datatype));
+    sl.add("count", channelStatistics.number_of_values_);
+    sl.add("nan_count", channelStatistics.nan_count_);
+    sl.add("inf_count", channelStatistics.inf_count_);
+    sl.add("min", format_double(hasFiniteValues ? channelStatistics.min_ : NAN));
+    sl.add("max", format_double(hasFiniteValues ? channelStatistics.max_ : NAN));
+    sl.add("mean", format_double(hasFiniteValues ? channelStatistics.mean_ : NAN));
+    sl.add("variance", format_double(channelStatistics.variance()));
+    sl.add("first", format_double(channelStatistics.first_));
+    sl.add("last", format_double(channelStatistics.last_));
+  }
+
+  /**
+   * @brief Write count, min, max, mean, variance, NaN and infinity count and first and last value
+   *        of channels into a xml file. Timestamps are given in seconds since the unix epoch.
+   *        The first and last timestamp is given for timestamp channels and for waveforms with
+   *        wf_start_time and wf_increment properties.
+   * 
+   * @param tdmsFilePath   path of the tdms file
+   * @param xmlFilePath    path of the xml file to write
+   * @param channelPaths   object paths of the channels. All numeric and timestamp channels if empty.
+   * @param threadCount    number of worker threads
+   * @param useIndexFile   read the meta data from .tdms_index files if available
+   */
+  void write_channel_statistics(const std::string& tdmsFilePath, const std::string& xmlFilePath, std::vector<std::string> channelPaths, const unsigned threadCount,
+    const bool useIndexFile = true)
+  {
+    const TdmsFileLayout layout = read_tdms_file_layout(tdmsFilePath, useIndexFile);
+    if (channelPaths.empty()) {
+      for (const auto& channelPath : layout.channel_paths()) {
+        const tdmsDataType datatype = layout.find_channel(channelPath)->rawInfo_.value_datatype();
+        if (is_tdms_data_type_numeric(datatype) || tdmsTypeTimeStamp == datatype) {
+          channelPaths.push_back(channelPath);
+        }
+      }
+    }
+    const std::vector<ChannelStatistics> statistics = compute_channel_statistics(tdmsFilePath, layout, channelPaths, threadCount);
+
+    ContentLoggerXml sl(xmlFilePath);
+    sl.push("statistics");
+    sl.add("filepath", tdmsFilePath);
+    sl.push("channels");
+    for (size_t channelIndex = 0; channelIndex < channelPaths.size(); ++channelIndex) {
+      const std::string& channelPath = channelPaths[channelIndex];
+      const ChannelStatistics& channelStatistics = statistics[channelIndex];
+      const tdmsDataType datatype = layout.find_channel(channelPath)->rawInfo_.value_datatype();
+      sl.push("channel");
+      log_channel_statistics(sl, channelPath, datatype, channelStatistics);
+
+      const PropertyValue* startTime = layout.find_property(channelPath, "wf_start_time");
+      const PropertyValue* increment = layout.find_property(channelPath, "wf_increment");
+      if (tdmsTypeTimeStamp == datatype) {
+        sl.add("first_timestamp", format_double(channelStatistics.first_));
+        sl.add("last_timestamp", format_double(channelStatistics.last_));
+      }
+      else if (nullptr != startTime && nullptr != increment && tdmsTypeTimeStamp == startTime->datatype_ && 0 != channelStatistics.number_of_values_) {
+        sl.add("first_timestamp", format_double(startTime->number_));
+        sl.add("last_timestamp", format_double(startTime->number_ + double(channelStatistics.number_of_values_ - 1) * increment->number_));
+      }
+      sl.pop();
+      std::cout << channelPath << " -> " << xmlFilePath << " (" << channelStatistics.number_of_values_ << " values)" << std::endl;
+    }
+    sl.pop();
+    sl.pop();
+  }
+
+  /**
+   * @brief Ordered set of tdms files seen as one dataset, e.g. the files of a logger rolling over
+   *        to a new file every hour. The samples of a channel are the samples of all files in
+   *        the given order. Each file keeps its own segment table and sample index, a cumulative
+   *        count over the files maps a sample to its file in O(log files). Nothing is merged.
+   */
+  class TdmsVirtualDataset
+  {
+  public:
+    /**
+     * @brief Samples of a channel over all files containing it
+     */
+    class ChannelIndex
+    {
+    public:
+      /**
+       * @brief Get the number of values of the channel over all files
+       */
+      uint64_t size() const
+      {
+        return first_values_.back();
+      }
+
+      /**
+       * @brief Get the data type of the channel, tdmsTypeVoid if it differs between files
+       */
+      tdmsDataType datatype() const
+      {
+        return datatype_;
+      }
+
+      /**
+       * @brief Get the number of files containing values of the channel
+       */
+      size_t file_count() const
+      {
+        return file_indices_.size();
+      }
+
+    private:
+      friend class TdmsVirtualDataset;
+
+      std::string path_;
+      tdmsDataType datatype_{ tdmsTypeVoid };
+      std::vector<size_t> file_indices_;
+      // index of the first value in each file followed by the total number of values
+      std::vector<uint64_t> first_values_{ 0LL };
+      std::vector<ChannelSampleIndex> indices_;
+    };
+
+    /**
+     * @brief Read the layouts of the files in parallel
+     * 
+     * @param tdmsFilePaths  paths of the tdms files in the order of their samples
+     * @param threadCount    number of worker threads
+     * @param useIndexFile   read the meta data from .tdms_index files if available
+     */
+    TdmsVirtualDataset(const std::vector<std::string>& tdmsFilePaths, const unsigned threadCount, const bool useIndexFile = true) :
+      file_paths_(tdmsFilePaths), layouts_(tdmsFilePaths.size())
+    {
+      std::atomic<size_t> nextFile{ 0 };
+      std::mutex errorMutex;
+      std::exception_ptr error;
+      const auto worker = [&]() {
+        for (size_t fileIndex = nextFile++; fileIndex < file_paths_.size(); fileIndex = nextFile++) {
+          try {
+            layouts_[fileIndex] = read_tdms_file_layout(file_paths_[fileIndex], useIndexFile);
+          }
+          catch (const std::exception& ex) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            error = std::make_exception_ptr(std::logic_error(file_paths_[fileIndex] + ": " + ex.what()));
+            nextFile = file_paths_.size();
+          }
+        }
+      };
+      std::vector<std::thread> threads;
+      for (unsigned threadIndex = 1; threadIndex < std::min<size_t>(std::max(1U, threadCount), file_paths_.size()); ++threadIndex) {
+        threads.emplace_back(worker);
+      }
+      worker();
+      for (auto& thread : threads) {
+        thread.join();
+      }
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+
+    TdmsVirtualDataset(const TdmsVirtualDataset&) = delete;
+    TdmsVirtualDataset& operator=(const TdmsVirtualDataset&) = delete;
+
+    const std::vector<std::string>& file_paths() const
+    {
+      return file_paths_;
+    }
+
+    const TdmsFileLayout& layout(const size_t fileIndex) const
+    {
+      return layouts_[fileIndex];
+    }
+
+    /**
+     * @brief Build the index of a channel over all files. Files without values of the channel
+     *        are skipped.
+     */
+    ChannelIndex channel_index(const std::string& channelPath) const
+    {
+      ChannelIndex index;
+      index.path_ = channelPath;
+      for (size_t fileIndex = 0; fileIndex < layouts_.size(); ++fileIndex) {
+        ChannelSampleIndex fileSampleIndex(layouts_[fileIndex], channelPath);
+        if (0 == fileSampleIndex.size()) {
+          continue;
+        }
+        const tdmsDataType datatype = layouts_[fileIndex].find_channel(channelPath)->rawInfo_.value_datatype();
+        index.datatype_ = index.file_indices_.empty() || datatype == index.datatype_ ? datatype : tdmsTypeVoid;
+        index.file_indices_.push_back(fileIndex);
+        index.first_values_.push_back(index.first_values_.back() + fileSampleIndex.size());
+        index.indices_.push_back(std::move(fileSampleIndex));
+      }
+      if (index.file_indices_.empty()) {
+        throw std::logic_error("Channel not found: " + channelPath);
+      }
+      return index;
+    }
+
+    /**
+     * @brief Find the file containing a sample of a channel
+     * 
+     * @return index of the file and of the sample inside of this file
+     */
+    std::pair<size_t, uint64_t> locate(const ChannelIndex& index, const uint64_t sampleIndex) const
+    {
+      if (sampleIndex >= index.size()) {
+        throw std::logic_error("Sample index out of range");
+      }
+      const size_t position = size_t(std::upper_bound(index.first_values_.begin(), index.first_values_.end(), sampleIndex) - index.first_values_.begin()) - 1;
+      return std::make_pair(index.file_indices_[position], sampleIndex - index.first_values_[position]);
+    }
+
+    /**
+     * @brief Read a range of samples of a channel, crossing file boundaries as needed. Only the
+     *        raw data of the samples is read.
+     * 
+     * @param index  index of the channel
+     * @param first  index of the first sample
+     * @param end    index behind the last sample
+     * @param sink   sink receiving the values
+     */
+    void extract_range(const ChannelIndex& index, const uint64_t first, const uint64_t end, ChannelSink& sink) const
+    {
+      for (const auto& part : split_range(index, first, end)) {
+        FileIo fileIo(file_paths_[index.file_indices_[part.position_]]);
+        ChannelExtractor extractor(fileIo, layouts_[index.file_indices_[part.position_]]);
+        extractor.extract_range(index.indices_[part.position_], part.first_, part.end_, sink);
+      }
+    }
+
+    /**
+     * @brief Compute the statistics of a range of samples of a numeric or timestamp channel. The
+     *        parts of the range in different files are processed in parallel and merged in order.
+     */
+    ChannelStatistics compute_statistics(const ChannelIndex& index, const uint64_t first, const uint64_t end, const unsigned threadCount) const
+    {
+      const std::vector<RangePart> parts = split_range(index, first, end);
+      std::vector<ChannelStatistics> partialStatistics(parts.size());
+      std::atomic<size_t> nextPart{ 0 };
+      std::mutex errorMutex;
+      std::exception_ptr error;
+      const auto worker = [&]() {
+        try {
+          for (size_t partIndex = nextPart++; partIndex < parts.size(); partIndex = nextPart++) {
+            const RangePart& part = parts[partIndex];
+            FileIo fileIo(file_paths_[index.file_indices_[part.position_]]);
+            ChannelExtractor extractor(fileIo, layouts_[index.file_indices_[part.position_]]);
+            ChannelSinkStatistics statisticsSink(partialStatistics[partIndex]);
+            ChannelSinkFloatingPoint<double> sink(statisticsSink);
+            extractor.extract_range(index.indices_[part.position_], part.first_, part.end_, sink);
+          }
+        }
+        catch (...) {
+          std::lock_guard<std::mutex> lock(errorMutex);
+          error = std::current_exception();
+          nextPart = parts.size();
+        }
+      };
+      std::vector<std::thread> threads;
+      for (unsigned threadIndex = 1; threadIndex < std::min<size_t>(std::max(1U, threadCount), parts.size()); ++threadIndex) {
+        threads.emplace_back(worker);
+      }
+      worker();
+      for (auto& thread : threads) {
+        thread.join();
+      }
+      if (error) {
+        std::rethrow_exception(error);
+      }
+      ChannelStatistics statistics;
+      for (const auto& partStatistics : partialStatistics) {
+        statistics.merge(partStatistics);
+      }
+      return statistics;
+    }
+
+  private:
+    /**
+     * @brief Range of samples of a channel inside of one file
+     */
+    struct RangePart
+    {
+      // position of the file in ChannelIndex
+      size_t position_;
+      uint64_t first_;
+      uint64_t end_;
+    };
+
+    static std::vector<RangePart> split_range(const ChannelIndex& index, const uint64_t first, const uint64_t end)
+    {
+      if (first > end || end > index.size()) {
+        throw std::logic_error("Sample range out of range");
+      }
+      std::vector<RangePart> parts;
+      if (first == end) {
+        return parts;
+      }
+      size_t position = size_t(std::upper_bound(index.first_values_.begin(), index.first_values_.end(), first) - index.first_values_.begin()) - 1;
+      for (uint64_t sampleIndex = first; sampleIndex < end; ++position) {
+        const uint64_t partEnd = std::min(end, index.first_values_[position + 1]);
+        parts.push_back(RangePart{ position, sampleIndex - index.first_values_[position], partEnd - index.first_values_[position] });
+        sampleIndex = partEnd;
+      }
+      return parts;
+    }
+
+    std::vector<std::string> file_paths_;
+    // sized once, the sample indices point into the layouts
+    std::vector<TdmsFileLayout> layouts_;
+  };
+
+  /**
+   * @brief Extract a range of samples of a channel spanning an ordered set of tdms files or
+   *        write its statistics.
+   * 
+   * @param tdmsFilePaths  paths of the tdms files in the order of their samples
+   * @param outPath        directory receiving the values or with asStatistics the xml file
+   * @param channelPath    object path of the channel
+   * @param asDouble       convert the values to double, needed if the data type differs between files
+   * @param asStatistics   write statistics instead of the values
+   * @param rangeFirst     index of the first sample over all files
+   * @param rangeEnd       index behind the last sample, limited to the number of samples
+   * @param threadCount    number of worker threads
+   * @param useIndexFile   read the meta data from .tdms_index files if available
+   */
+  void extract_virtual_channel(const std::vector<std::string>& tdmsFilePaths, const std::string& outPath, const std::string& channelPath,
+    const bool asDouble, const bool asStatistics, const uint64_t rangeFirst, const uint64_t rangeEnd, const unsigned threadCount, const bool useIndexFile = true)
+  {
+    const TdmsVirtualDataset dataset(tdmsFilePaths, threadCount, useIndexFile);
+    const TdmsVirtualDataset::ChannelIndex index = dataset.channel_index(channelPath);
+    const uint64_t end = std::min(rangeEnd, index.size());
+    const tdmsDataType datatype = index.datatype();
+    if (asStatistics || asDouble) {
+      if (tdmsTypeVoid != datatype && !is_tdms_data_type_numeric(datatype) && tdmsTypeTimeStamp != datatype) {
+        throw std::logic_error("Channel can not be converted to double");
+      }
+    }
+    else if (tdmsTypeVoid == datatype) {
+      throw std::logic_error("Data type of channel differs between files, use --as-double");
+    }
+    else if (tdmsTypeString == datatype) {
+      throw std::logic_error("String channels are not supported by virtual datasets");
+    }
+
+    if (asStatistics) {
+      const ChannelStatistics statistics = dataset.compute_statistics(index, rangeFirst, end, threadCount);
+      ContentLoggerXml sl(outPath);
+      sl.push("statistics");
+      sl.push("files");
+      for (const auto& tdmsFilePath : dataset.file_paths()) {
+        sl.add("filepath", tdmsFilePath);
+      }
+      sl.pop();
+      sl.add("first_sample", rangeFirst);
+      sl.push("channels");
+      sl.push("channel");
+      log_channel_statistics(sl, channelPath, datatype, statistics);
+      if (tdmsTypeTimeStamp == datatype) {
+        sl.add("first_timestamp", format_double(statistics.first_));
+        sl.add("last_timestamp", format_double(statistics.last_));
+      }
+      else if (0 != statistics.number_of_values_) {
+        // each file starts its own waveform
+        const auto get_timestamp = [&](const uint64_t sampleIndex) -> double {
+          const std::pair<size_t, uint64_t> location = dataset.locate(index, sampleIndex);
+          const PropertyValue* startTime = dataset.layout(location.first).find_property(channelPath, "wf_start_time");
+          const PropertyValue* increment = dataset.layout(location.first).find_property(channelPath, "wf_increment");
+          if (nullptr == startTime || nullptr == increment || tdmsTypeTimeStamp != startTime->datatype_) {
+            return NAN;
+          }
+          return startTime->number_ + double(location.second) * increment->number_;
+        };
+        const double firstTimestamp = get_timestamp(rangeFirst);
+        const double lastTimestamp = get_timestamp(end - 1);
+        if (!std::isnan(firstTimestamp) && !std::isnan(lastTimestamp)) {
+          sl.add("first_timestamp", format_double(firstTimestamp));
+          sl.add("last_timestamp", format_double(lastTimestamp));
+        }
+      }
+      sl.pop();
+      sl.pop();
+      sl.pop();
+      std::cout << channelPath << " -> " << outPath << " (" << statistics.number_of_values_ << " values from " << index.file_count() << " files)" << std::endl;
+      return;
+    }
+
+    const std::string binFilePath = (std::filesystem::path(outPath) / (get_channel_file_name(channelPath) + ".bin")).string();
+    ChannelSinkFile fileSink(binFilePath);
+    if (asDouble) {
+      ChannelSinkFloatingPoint<double> sink(fileSink);
+      dataset.extract_range(index, rangeFirst, end, sink);
+    }
+    else {
+      dataset.extract_range(index, rangeFirst, end, fileSink);
+    }
+    std::cout << channelPath << " -> " << binFilePath << " (" << fileSink.number_of_values() << " values from " << index.file_count() << " files)" << std::endl;
+  }
+
+  inline uint64_t rotate_left_64(const uint64_t value, const int bits)
+  {
+    return (value << bits) | (value >> (64 - bits));
+  }
+
+  /**
+   * @brief Read an unsigned integer stored in little endian byte order
+   */
+  template<class T> inline T load_little_endian(const uint8_t* data)
+  {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    if (SgmtFileIo::is_big_endian_os()) {
+      if constexpr (8 == sizeof(T)) {
+        value = byte_swap_64(value);
+      }
+      else {
+        value = byte_swap_32(value);
+      }
+    }
+    return value;
+  }
+
+  /**
+   * @brief Compute the 64 bit xxHash (XXH64) of a memory block
+   * 
+   * @param data  bytes to hash
+   * @param size  number of bytes
+   * @param seed  seed of the hash
+   * @return hash identical to the reference implementation of XXH64
+   */
+  uint64_t xxhash64(const uint8_t* data, const uint64_t size, const uint64_t seed = 0)
+  {
+    constexpr uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr uint64_t prime3 = 0x165667B19E3779F9ULL;
+    constexpr uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+    const auto round = [](uint64_t accumulator, const uint64_t input) {
+      accumulator += input * prime2;
+      return rotate_left_64(accumulator, 31) * prime1;
+    };
+    const auto merge_round = [&round](uint64_t hash, const uint64_t accumulator) {
+      hash ^= round(0, accumulator);
+      return hash * prime1 + prime4;
+    };
+
+    const uint8_t* position = data;
+    const uint8_t* const end = data + size;
+    uint64_t hash;
+    if (size >= 32) {
+      // four independent lanes over stripes of 32 bytes
+      uint64_t lane1 = seed + prime1 + prime2;
+      uint64_t lane2 = seed + prime2;
+      uint64_t lane3 = seed;
+      uint64_t lane4 = seed - prime1;
+      for (; position + 32 <= end; position += 32) {
+        lane1 = round(lane1, load_little_endian<uint64_t>(position));
+        lane2 = round(lane2, load_little_endian<uint64_t>(position + 8));
+        lane3 = round(lane3, load_little_endian<uint64_t>(position + 16));
+        lane4 = round(lane4, load_little_endian<uint64_t>(position + 24));
+      }
+      hash = rotate_left_64(lane1, 1) + rotate_left_64(lane2, 7) + rotate_left_64(lane3, 12) + rotate_left_64(lane4, 18);
+      hash = merge_round(hash, lane1);
+      hash = merge_round(hash, lane2);
+      hash = merge_round(hash, lane3);
+      hash = merge_round(hash, lane4);
+    }
+    else {
+      hash = seed + prime5;
+    }
+    hash += size;
+
+    for (; position + 8 <= end; position += 8) {
+      hash ^= round(0, load_little_endian<uint64_t>(position));
+      hash = rotate_left_64(hash, 27) * prime1 + prime4;
+    }
+    if (position + 4 <= end) {
+      hash ^= uint64_t(load_little_endian<uint32_t>(position)) * prime1;
+      hash = rotate_left_64(hash, 23) * prime2 + prime3;
+      position += 4;
+    }
+    for (; position < end; ++position) {
+      hash ^= *position * prime5;
+      hash = rotate_left_64(hash, 11) * prime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
+  }
+
+  /**
+   * @brief Hash the meta data (including the lead in) and the raw data of each segment in parallel.
+   *        Worker threads take segments largest first from a shared counter. The tree hash is the
+   *        XXH64 of the little endian meta and raw data hashes of all segments in file order, so
+   *        two files with the same tree hash contain the same segments.
+   * 
+   * @param tdmsFilePath  path of the tdms file
+   * @param layout        layout of the tdms file
+   * @param threadCount   number of worker threads
+   * @return hashes of all segments
+   */
+  FileHashes compute_file_hashes(const std::string& tdmsFilePath, const TdmsFileLayout& layout, const unsigned threadCount)
+  {
+    const MappedFile file(tdmsFilePath);
+    const size_t segmentCount = layout.segments_.size();
+    const auto clamp = [&file](const uint64_t offset) {
+      return std::min(offset, file.size());
+    };
+
+    std::vector<size_t> order(segmentCount);
+    for (size_t segmentIndex = 0; segmentIndex < segmentCount; ++segmentIndex) {
+      order[segmentIndex] = segmentIndex;
+    }
+    const auto segment_size = [&](const size_t segmentIndex) {
+      const SgmtLayout& segment = layout.segments_[segmentIndex];
+      return clamp(segment.raw_data_absolute_end_) - clamp(segment.absolute_offset_);
+    };
+    std::stable_sort(order.begin(), order.end(), [&](const size_t lhs, const size_t rhs) {
+      return segment_size(lhs) > segment_size(rhs);
+    });
+
+    FileHashes hashes;
+    hashes.segments_.resize(segmentCount);
+    std::atomic<size_t> nextSegment{ 0 };
+    const auto worker = [&]() {
+      for (size_t orderIndex = nextSegment++; orderIndex < segmentCount; orderIndex = nextSegment++) {
+        const SgmtLayout& segment = layout.segments_[order[orderIndex]];
+        const uint64_t metaDataBegin = clamp(segment.absolute_offset_);
+        const uint64_t rawDataBegin = std::max(metaDataBegin, clamp(segment.raw_data_absolute_offset_));
+        const uint64_t rawDataEnd = std::max(rawDataBegin, clamp(segment.raw_data_absolute_end_));
+        SgmtHashes& sgmtHashes = hashes.segments_[order[orderIndex]];
+        sgmtHashes.meta_data_ = xxhash64(file.data() + metaDataBegin, rawDataBegin - metaDataBegin);
+        sgmtHashes.raw_data_ = xxhash64(file.data() + rawDataBegin, rawDataEnd - rawDataBegin);
+      }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned threadIndex = 1; threadIndex < std::min<size_t>(std::max(1U, threadCount), segmentCount); ++threadIndex) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    std::map<std::pair<uint64_t, uint64_t>, long> firstSegments;
+    std::vector<uint8_t> segmentHashes;
+    for (size_t segmentIndex = 0; segmentIndex < segmentCount; ++segmentIndex) {
+      SgmtHashes& sgmtHashes = hashes.segments_[segmentIndex];
+      const auto inserted = firstSegments.emplace(std::make_pair(sgmtHashes.meta_data_, sgmtHashes.raw_data_), long(segmentIndex));
+      if (!inserted.second) {
+        sgmtHashes.duplicate_of_ = inserted.first->second;
+      }
+      for (const uint64_t hash : { sgmtHashes.meta_data_, sgmtHashes.raw_data_ }) {
+        for (int byteIndex = 0; byteIndex < 8; ++byteIndex) {
+          segmentHashes.push_back(uint8_t(hash >> (8 * byteIndex)));
+        }
+      }
+    }
+    hashes.tree_ = xxhash64(segmentHashes.data(), segmentHashes.size());
+    return hashes;
+  }
+
+  /**
+   * @brief Dump the structure of a tdms file with the content hashes of all segments and the tree
+   *        hash of the file. Segments identical to an earlier segment are marked as duplicate.
+   * 
+   * @param tdmsFilePath  path of the tdms file
+   * @param xmlFilePath   path of the xml file to write
+   * @param threadCount   number of worker threads
+   * @param useIndexFile  read the meta data from .tdms_index files if available
+   */
+  void write_tdms_file_hashes(const std::string& tdmsFilePath, const std::string& xmlFilePath, const unsigned threadCount, const bool useIndexFile = true)
+  {
+    const TdmsFileLayout layout = read_tdms_file_layout(tdmsFilePath, useIndexFile);
+    const FileHashes hashes = compute_file_hashes(tdmsFilePath, layout, threadCount);
+    {
+      ContentLoggerXml structLog(xmlFilePath);
+      log_tdms_file_structure<std::string>(tdmsFilePath, structLog, nullptr, &hashes, useIndexFile);
+    }
+    for (size_t segmentIndex = 0; segmentIndex < hashes.segments_.size(); ++segmentIndex) {
+      if (0 <= hashes.segments_[segmentIndex].duplicate_of_) {
+        std::cout << "segment " << segmentIndex << " duplicates segment " << hashes.segments_[segmentIndex].duplicate_of_ << std::endl;
+      }
+    }
+    std::cout << tdmsFilePath << " -> " << xmlFilePath << " (tree hash " << format_hash(hashes.tree_) << ")" << std::endl;
+  }
+
+  /**
+   * @brief Collect the tdms files to process in batch mode
+   * 
+   * @param paths          tdms files and directories searched recursively for *.tdms files
+   * @param listFilePath   text file containing one path per line, ignored if empty
+   * @return paths of the tdms files
+   */
+  std::vector<std::string> collect_tdms_file_paths(std::vector<std::string> paths, const std::string& listFilePath)
+  {
+    if (!listFilePath.empty()) {
+      std::ifstream ifs(std::filesystem::u8path(listFilePath));
+      if (!ifs) {
+        throw std::logic_error("Failed to open file list");
+      }
+      std::string line;
+      while (std::getline(ifs, line)) {
+        if (!line.empty() && '\r' == line.back()) {
+          line.pop_back();
+        }
+        if (!line.empty()) {
+          paths.push_back(line);
+        }
+      }
+    }
+
+    std::vector<std::string> tdmsFilePaths;
+    for (const auto& path : paths) {
+      const std::filesystem::path fsPath = std::filesystem::u8path(path);
+      if (!std::filesystem::is_directory(fsPath)) {
+        tdmsFilePaths.push_back(path);
+        continue;
+      }
+      std::vector<std::string> directoryFilePaths;
+      for (const auto& entry : std::filesystem::recursive_directory_iterator(fsPath, std::filesystem::directory_options::skip_permission_denied)) {
+        std::string extension = entry.path().extension().u8string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c) { return char(std::tolower(c)); });
+        if (".tdms" == extension && entry.is_regular_file()) {
+          directoryFilePaths.push_back(entry.path().u8string());
+        }
+      }
+      std::sort(directoryFilePaths.begin(), directoryFilePaths.end());
+      tdmsFilePaths.insert(tdmsFilePaths.end(), directoryFilePaths.begin(), directoryFilePaths.end());
+    }
+    return tdmsFilePaths;
+  }
+
+  /**
+   * @brief Dump the structure of many tdms files in parallel. The files are sorted by size and
+   *        worker threads take the largest remaining file from a shared cursor, so a few big
+   *        files do not end up at the tail of one thread. A file that fails is reported and
+   *        does not stop the batch.
+   * 
+   * @param tdmsFilePaths        paths of the tdms files
+   * @param combinedXmlFilePath  if not empty all structures are written into this xml file in
+   *                             order of completion, otherwise next to each tdms file through a
+   *                             temporary file so an existing structure is replaced at once
+   * @param threadCount          number of worker threads
+   * @param withHashes           add segment hashes like --hash
+   * @param useIndexFile         read the meta data from .tdms_index files if available
+   * @return number of files that failed
+   */
+  size_t dump_tdms_file_structures(const std::vector<std::string>& tdmsFilePaths, const std::string& combinedXmlFilePath,
+    const unsigned threadCount, const bool withHashes, const bool useIndexFile)
+  {
+    std::vector<std::pair<uint64_t, size_t>> order;
+    for (size_t fileIndex = 0; fileIndex < tdmsFilePaths.size(); ++fileIndex) {
+      std::error_code errorCode;
+      const uintmax_t fileSize = std::filesystem::file_size(std::filesystem::u8path(tdmsFilePaths[fileIndex]), errorCode);
+      order.emplace_back(errorCode ? 0 : uint64_t(fileSize), fileIndex);
+    }
+    std::stable_sort(order.begin(), order.end(), [](const auto& lhs, const auto& rhs) {
+      return lhs.first > rhs.first;
+    });
+
+    const bool combinedGiven = !combinedXmlFilePath.empty();
+    std::ofstream combined;
+    if (combinedGiven) {
+      combined.open(std::filesystem::u8path(combinedXmlFilePath), std::ios::binary | std::ios::out | std::ios::trunc);
+      if (!combined) {
+        throw std::logic_error("Failed to create file");
+      }
+      combined << R"(<?xml version="1.0" encoding="UTF-8" standalone="no" ?>)" << std::endl;
+      combined << "<batch>" << std::endl;
+    }
+
+    std::mutex outputMutex;
+    std::atomic<size_t> nextFile{ 0 };
+    std::atomic<size_t> failedCount{ 0 };
+    const auto dump_structure = [&](const std::string& tdmsFilePath, auto& structLog) {
+      if (withHashes) {
+        const FileHashes hashes = compute_file_hashes(tdmsFilePath, read_tdms_file_layout(tdmsFilePath, useIndexFile), 1);
+        log_tdms_file_structure(tdmsFilePath, structLog, nullptr, &hashes, useIndexFile);
+      }
+      else {
+        log_tdms_file_structure(tdmsFilePath, structLog, nullptr, nullptr, useIndexFile);
+      }
+    };
+    const auto worker = [&]() {
+      for (size_t orderIndex = nextFile++; orderIndex < order.size(); orderIndex = nextFile++) {
+        const std::string& tdmsFilePath = tdmsFilePaths[order[orderIndex].second];
+        const std::string xmlFilePath = combinedGiven ? combinedXmlFilePath : tdmsFilePath + ".structure.xml";
+        const std::filesystem::path fsXmlFilePath = std::filesystem::u8path(xmlFilePath);
+        std::filesystem::path temporaryFilePath = fsXmlFilePath;
+        temporaryFilePath += "." + std::to_string(std::random_device()()) + ".tmp";
+        std::ostringstream fragment;
+        try {
+          if (combinedGiven) {
+            ContentLoggerXml structLog(fragment, 1);
+            dump_structure(tdmsFilePath, structLog);
+          }
+          else {
+            {
+              ContentLoggerXml structLog(temporaryFilePath);
+              dump_structure(tdmsFilePath, structLog);
+            }
+            std::filesystem::rename(temporaryFilePath, fsXmlFilePath);
+          }
+          std::lock_guard<std::mutex> lock(outputMutex);
+          if (combinedGiven) {
+            combined << fragment.str();
+          }
+          std::cout << tdmsFilePath << " -> " << xmlFilePath << std::endl;
+        }
+        catch (const std::exception& ex) {
+          ++failedCount;
+          std::ostringstream errorFragment;
+          if (combinedGiven) {
+            ContentLoggerXml errorLog(errorFragment, 1);
+            errorLog.push("file");
+            errorLog.add("filepath", tdmsFilePath);
+            errorLog.add("error", std::string(ex.what()));
+            errorLog.pop();
+          }
+          else {
+            // keep the structure of a previous run instead of a partial one
+            std::error_code errorCode;
+            std::filesystem::remove(temporaryFilePath, errorCode);
+          }
+          std::lock_guard<std::mutex> lock(outputMutex);
+          if (combinedGiven) {
+            combined << errorFragment.str();
+          }
+          std::cerr << "EXCEPTION: " << tdmsFilePath << ": " << ex.what() << std::endl;
+        }
+      }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned threadIndex = 1; threadIndex < std::min<size_t>(std::max(1U, threadCount), order.size()); ++threadIndex) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    if (combinedGiven) {
+      combined << "</batch>" << std::endl;
+      if (!combined) {
+        throw std::logic_error("Failed to write bytes");
+      }
+    }
+    std::cout << tdmsFilePaths.size() << " files, " << failedCount << " failed" << std::endl;
+    return failedCount;
+  }
+
+  /**
+   * @brief Kind of an object in the catalog
+   */
+  enum CatalogObjectKind {
+    catalogObjectKindFile = 0,
+    catalogObjectKindGroup = 1,
+    catalogObjectKindChannel = 2
+  };
+
+  /**
+   * @brief Object of a tdms file collected for the catalog
+   */
+  class CatalogObject
+  {
+  public:
+    std::string path_;
+    CatalogObjectKind kind_{ catalogObjectKindFile };
+    tdmsDataType datatype_{ tdmsTypeVoid };
+    uint64_t number_of_values_{ 0LL };
+    // unix seconds, NaN if unknown
+    double first_time_{ NAN };
+    double last_time_{ NAN };
+    std::vector<std::pair<std::string, std::string>> properties_;
+  };
+
+  /**
+   * @brief Objects of a tdms file ordered as file object, then each group followed by its channels
+   */
+  class CatalogFile
+  {
+  public:
+    std::string path_;
+    uint64_t size_{ 0LL };
+    std::vector<CatalogObject> objects_;
+  };
+
+  /**
+   * @brief Format a property value as indexed by the catalog. Numbers, booleans and timestamps
+   *        (unix seconds) use the shortest representation that reads back to the same double.
+   */
+  std::string format_property_value(const PropertyValue& value)
+  {
+    if (tdmsTypeString == value.datatype_) {
+      return value.string_;
+    }
+    std::ostringstream ost;
+    ost.imbue(std::locale("C"));
+    ost.precision(15);
+    ost << value.number_;
+    if (std::isfinite(value.number_) && std::stod(ost.str()) != value.number_) {
+      return format_double(value.number_);
+    }
+    return ost.str();
+  }
+
+  /**
+   * @brief Collect the objects of a tdms file for the catalog. Only the meta data is read except
+   *        for the first and last value of timestamp channels. The time range of a channel is
+   *        taken from wf_start_time and wf_increment, from its own values for timestamp channels
+   *        or else from the union of the time ranges of the channels in its group.
+   * 
+   * @param tdmsFilePath  path of the tdms file
+   * @param layout        layout of the tdms file
+   * @return objects of the file
+   */
+  CatalogFile read_catalog_file(const std::string& tdmsFilePath, const TdmsFileLayout& layout)
+  {
+    std::map<std::string, uint64_t> numberOfValues;
+    std::map<std::string, tdmsDataType> datatypes;
+    for (const auto& segment : layout.segments_) {
+      for (const auto& channel : segment.channels_) {
+        numberOfValues[channel.rawInfo_.objPath_] += channel.rawInfo_.number_of_values_ * segment.number_of_chunks_;
+        datatypes.emplace(channel.rawInfo_.objPath_, channel.rawInfo_.value_datatype());
+      }
+    }
+
+    // groups in order of appearance of their channels, then groups without raw data
+    std::vector<std::string> groupPaths;
+    std::map<std::string, std::vector<std::string>> channelPathsOfGroup;
+    const auto add_object = [&](const std::string& objPath) {
+      const std::string parentPath = get_parent_object_path(objPath);
+      const std::string groupPath = "/" == parentPath ? objPath : parentPath;
+      if (parentPath.empty()) {
+        return;
+      }
+      if (channelPathsOfGroup.end() == channelPathsOfGroup.find(groupPath)) {
+        groupPaths.push_back(groupPath);
+        channelPathsOfGroup[groupPath];
+      }
+      std::vector<std::string>& channelPaths = channelPathsOfGroup[groupPath];
+      if (groupPath != objPath && channelPaths.end() == std::find(channelPaths.begin(), channelPaths.end(), objPath)) {
+        channelPaths.push_back(objPath);
+      }
+    };
+    for (const auto& channelPath : layout.channel_paths()) {
+      add_object(channelPath);
+    }
+    for (const auto& objectProperties : layout.properties_) {
+      add_object(objectProperties.first);
+    }
+
+    CatalogFile catalogFile;
+    catalogFile.path_ = tdmsFilePath;
+    catalogFile.size_ = layout.size_;
+    const auto make_object = [&](const std::string& objPath, const CatalogObjectKind kind) {
+      CatalogObject object;
+      object.path_ = objPath;
+      object.kind_ = kind;
+      const ObjectProperties* properties = layout.find_properties(objPath);
+      if (nullptr != properties) {
+        for (const auto& property : *properties) {
+          object.properties_.emplace_back(property.first, format_property_value(property.second));
+        }
+      }
+      return object;
+    };
+    const auto merge_time_range = [](CatalogObject& target, const CatalogObject& source) {
+      if (!std::isnan(source.first_time_)) {
+        target.first_time_ = std::isnan(target.first_time_) ? source.first_time_ : std::min(target.first_time_, source.first_time_);
+        target.last_time_ = std::isnan(target.last_time_) ? source.last_time_ : std::max(target.last_time_, source.last_time_);
+      }
+    };
+
+    FileIo fileIo(tdmsFilePath);
+    ChannelExtractor extractor(fileIo, layout);
+    catalogFile.objects_.push_back(make_object("/", catalogObjectKindFile));
+    for (const auto& groupPath : groupPaths) {
+      const size_t groupIndex = catalogFile.objects_.size();
+      catalogFile.objects_.push_back(make_object(groupPath, catalogObjectKindGroup));
+      for (const auto& channelPath : channelPathsOfGroup[groupPath]) {
+        CatalogObject channel = make_object(channelPath, catalogObjectKindChannel);
+        const auto datatype = datatypes.find(channelPath);
+        channel.datatype_ = datatypes.end() == datatype ? tdmsTypeVoid : datatype->second;
+        channel.number_of_values_ = numberOfValues[channelPath];
+        const PropertyValue* startTime = layout.find_property(channelPath, "wf_start_time");
+        const PropertyValue* increment = layout.find_property(channelPath, "wf_increment");
+        if (nullptr != startTime && nullptr != increment && tdmsTypeTimeStamp == startTime->datatype_ && 0 != channel.number_of_values_) {
+          channel.first_time_ = startTime->number_;
+          channel.last_time_ = startTime->number_ + double(channel.number_of_values_ - 1) * increment->number_;
+        }
+        else if (tdmsTypeTimeStamp == channel.datatype_ && 0 != channel.number_of_values_) {
+          const ChannelSampleIndex index(layout, channelPath);
+          ChannelStatistics statistics;
+          ChannelSinkStatistics statisticsSink(statistics);
+          ChannelSinkFloatingPoint<double> sink(statisticsSink);
+          extractor.extract_range(index, 0, 1, sink);
+          extractor.extract_range(index, index.size() - 1, index.size(), sink);
+          channel.first_time_ = statistics.first_;
+          channel.last_time_ = statistics.last_;
+        }
+        catalogFile.objects_.push_back(channel);
+      }
+      for (size_t channelIndex = groupIndex + 1; channelIndex < catalogFile.objects_.size(); ++channelIndex) {
+        merge_time_range(catalogFile.objects_[groupIndex], catalogFile.objects_[channelIndex]);
+      }
+      for (size_t channelIndex = groupIndex + 1; channelIndex < catalogFile.objects_.size(); ++channelIndex) {
+        CatalogObject& channel = catalogFile.objects_[channelIndex];
+        if (std::isnan(channel.first_time_)) {
+          channel.first_time_ = catalogFile.objects_[groupIndex].first_time_;
+          channel.last_time_ = catalogFile.objects_[groupIndex].last_time_;
+        }
+      }
+      merge_time_range(catalogFile.objects_.front(), catalogFile.objects_[groupIndex]);
+    }
+    return catalogFile;
+  }
+
+  /**
+   * @brief Records of the catalog file. All sections start at multiples of 8 bytes.
+   */
+  struct CatalogFileRecord
+  {
+    uint64_t path_offset;
+    uint64_t path_size;
+    uint64_t size;
+    uint64_t first_object;
+    uint64_t object_count;
+  };
+
+  struct CatalogObjectRecord
+  {
+    uint64_t path_offset;
+    uint64_t path_size;
+    uint64_t file_index;
+    // index behind the last object below this object: all channels of a file or group
+    uint64_t subtree_end;
+    uint32_t kind;
+    uint32_t datatype;
+    uint64_t number_of_values;
+    double first_time;
+    double last_time;
+  };
+
+  struct CatalogEntryRecord
+  {
+    uint64_t name_offset;
+    uint64_t name_size;
+    uint64_t value_offset;
+    uint64_t value_size;
+    uint64_t first_posting;
+    uint64_t posting_count;
+  };
+
+  /**
+   * @brief Write the catalog file. It is written in the byte order of the operating system to be
+   *        mapped by TdmsCatalog:
+   * 
+   *        char[4]   "TDSk"
+   *        uint32    version 1
+   *        uint64    number of files, objects, postings and index entries, size of the string pool
+   *        CatalogFileRecord[files]
+   *        CatalogObjectRecord[objects]
+   *        uint64[postings]              object indices of the index entries
+   *        CatalogEntryRecord[entries]   sorted by property name and value
+   *        char[size]                    string pool referenced by offset and size
+   * 
+   *        The file is replaced at once so running queries never map a partial catalog.
+   * 
+   * @param catalogFilePath  path of the catalog file
+   * @param catalogFiles     objects of the tdms files
+   */
+  void write_tdms_catalog_file(const std::string& catalogFilePath, const std::vector<const CatalogFile*>& catalogFiles)
+  {
+    std::string strings;
+    const auto add_string = [&strings](const std::string& value) {
+      const uint64_t offset = strings.size();
+      strings += value;
+      return offset;
+    };
+    std::vector<CatalogFileRecord> fileRecords;
+    std::vector<CatalogObjectRecord> objectRecords;
+    std::map<std::pair<std::string, std::string>, std::vector<uint64_t>> postingsOfProperty;
+    for (const auto catalogFile : catalogFiles) {
+      const uint64_t firstObject = objectRecords.size();
+      fileRecords.push_back(CatalogFileRecord{ add_string(catalogFile->path_), catalogFile->path_.size(), catalogFile->size_, firstObject, catalogFile->objects_.size() });
+      uint64_t groupRecord{ 0 };
+      for (const auto& object : catalogFile->objects_) {
+        const uint64_t objectIndex = objectRecords.size();
+        if (catalogObjectKindGroup == object.kind_) {
+          groupRecord = objectIndex;
+        }
+        objectRecords.push_back(CatalogObjectRecord{ add_string(object.path_), object.path_.size(), fileRecords.size() - 1, objectIndex + 1,
+          uint32_t(object.kind_), uint32_t(object.datatype_), object.number_of_values_, object.first_time_, object.last_time_ });
+        objectRecords[firstObject].subtree_end = objectIndex + 1;
+        if (catalogObjectKindChannel == object.kind_) {
+          objectRecords[groupRecord].subtree_end = objectIndex + 1;
+        }
+        for (const auto& property : object.properties_) {
+          postingsOfProperty[property].push_back(objectIndex);
+        }
+      }
+    }
+    std::vector<uint64_t> postings;
+    std::vector<CatalogEntryRecord> entryRecords;
+    for (const auto& property : postingsOfProperty) {
+      entryRecords.push_back(CatalogEntryRecord{ add_string(property.first.first), property.first.first.size(),
+        add_string(property.first.second), property.first.second.size(), postings.size(), property.second.size() });
+      postings.insert(postings.end(), property.second.begin(), property.second.end());
+    }
+
+    const std::filesystem::path fsCatalogFilePath = std::filesystem::u8path(catalogFilePath);
+    std::filesystem::path temporaryFilePath = fsCatalogFilePath;
+    temporaryFilePath += "." + std::to_string(std::random_device()()) + ".tmp";
+    std::ofstream ofs(temporaryFilePath, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!ofs) {
+      throw std::logic_error("Failed to create file");
+    }
+    const auto write_value = [&ofs](const auto& value) {
+      ofs.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    const auto write_records = [&ofs](const auto& records) {
+      ofs.write(reinterpret_cast<const char*>(records.data()), std::streamsize(records.size() * sizeof(records[0])));
+    };
+    ofs.write("TDSk", 4);
+    write_value(uint32_t(1));
+    write_value(uint64_t(fileRecords.size()));
+    write_value(uint64_t(objectRecords.size()));
+    write_value(uint64_t(postings.size()));
+    write_value(uint64_t(entryRecords.size()));
+    write_value(uint64_t(strings.size()));
+    write_records(fileRecords);
+    write_records(objectRecords);
+    write_records(postings);
+    write_records(entryRecords);
+    ofs.write(strings.data(), std::streamsize(strings.size()));
+    ofs.close();
+    if (!ofs) {
+      throw std::logic_error("Failed to write bytes");
+    }
+    std::filesystem::rename(temporaryFilePath, fsCatalogFilePath);
+    std::cout << catalogFilePath << " (" << fileRecords.size() << " files, " << objectRecords.size() << " objects, "
+      << entryRecords.size() << " property values)" << std::endl;
+  }
+
+  /**
+   * @brief Write a catalog of many tdms files. The files are read in parallel, largest first.
+   * 
+   * @param catalogFilePath  path of the catalog file
+   * @param tdmsFilePaths    paths of the tdms files
+   * @param threadCount      number of worker threads
+   * @param useIndexFile     read the meta data from .tdms_index files if available
+   * @return number of files that could not be read
+   */
+  size_t write_tdms_catalog(const std::string& catalogFilePath, const std::vector<std::string>& tdmsFilePaths, const unsigned threadCount,
+    const bool useIndexFile = true)
+  {
+    std::vector<std::pair<uint64_t, size_t>> order;
+    for (size_t fileIndex = 0; fileIndex < tdmsFilePaths.size(); ++fileIndex) {
+      std::error_code errorCode;
+      const uintmax_t fileSize = std::filesystem::file_size(std::filesystem::u8path(tdmsFilePaths[fileIndex]), errorCode);
+      order.emplace_back(errorCode ? 0 : uint64_t(fileSize), fileIndex);
+    }
+    std::stable_sort(order.begin(), order.end(), [](const auto& lhs, const auto& rhs) {
+      return lhs.first > rhs.first;
+    });
+
+    std::vector<std::unique_ptr<CatalogFile>> catalogFiles(tdmsFilePaths.size());
+    std::mutex outputMutex;
+    std::atomic<size_t> nextFile{ 0 };
+    const auto worker = [&]() {
+      for (size_t orderIndex = nextFile++; orderIndex < order.size(); orderIndex = nextFile++) {
+        const std::string& tdmsFilePath = tdmsFilePaths[order[orderIndex].second];
+        try {
+          catalogFiles[order[orderIndex].second].reset(new CatalogFile(read_catalog_file(tdmsFilePath, read_tdms_file_layout(tdmsFilePath, useIndexFile))));
+        }
+        catch (const std::exception& ex) {
+          std::lock_guard<std::mutex> lock(outputMutex);
+          std::cerr << "EXCEPTION: " << tdmsFilePath << ": " << ex.what() << std::endl;
+        }
+      }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned threadIndex = 1; threadIndex < std::min<size_t>(std::max(1U, threadCount), order.size()); ++threadIndex) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    std::vector<const CatalogFile*> readFiles;
+    for (const auto& catalogFile : catalogFiles) {
+      if (catalogFile) {
+        readFiles.push_back(catalogFile.get());
+      }
+    }
+    write_tdms_catalog_file(catalogFilePath, readFiles);
+    return catalogFiles.size() - readFiles.size();
+  }
+
+  /**
+   * @brief Read only view of a catalog file written by write_tdms_catalog. The file is mapped and
+   *        records and strings are accessed in place. Counts, indices and offsets read from the
+   *        file are checked against its size, a corrupt catalog throws instead of reading outside.
+   */
+  class TdmsCatalog
+  {
+  public:
+    static constexpr size_t header_size = 48;
+
+    explicit TdmsCatalog(const std::string& catalogFilePath) :
+      file_(catalogFilePath)
+    {
+      if (file_.size() < header_size || 0 != std::memcmp(file_.data(), "TDSk", 4) || 1 != read<uint32_t>(4)) {
+        throw std::logic_error("Not a catalog file");
+      }
+      file_count_ = read<uint64_t>(8);
+      object_count_ = read<uint64_t>(16);
+      posting_count_ = read<uint64_t>(24);
+      entry_count_ = read<uint64_t>(32);
+      strings_size_ = read<uint64_t>(40);
+      // each count is limited by the file size first so the offsets can not overflow
+      uint64_t remainingSize = file_.size() - header_size;
+      const auto take_section = [&remainingSize](const uint64_t count, const uint64_t recordSize) {
+        if (count > remainingSize / recordSize) {
+          throw std::logic_error("Catalog file is corrupt");
+        }
+        remainingSize -= count * recordSize;
+      };
+      take_section(file_count_, sizeof(CatalogFileRecord));
+      take_section(object_count_, sizeof(CatalogObjectRecord));
+      take_section(posting_count_, sizeof(uint64_t));
+      take_section(entry_count_, sizeof(CatalogEntryRecord));
+      if (strings_size_ != remainingSize) {
+        throw std::logic_error("Catalog file is corrupt");
+      }
+      files_offset_ = header_size;
+      objects_offset_ = files_offset_ + file_count_ * sizeof(CatalogFileRecord);
+      postings_offset_ = objects_offset_ + object_count_ * sizeof(CatalogObjectRecord);
+      entries_offset_ = postings_offset_ + posting_count_ * sizeof(uint64_t);
+      strings_offset_ = entries_offset_ + entry_count_ * sizeof(CatalogEntryRecord);
+    }
+
+    uint64_t object_count() const
+    {
+      return object_count_;
+    }
+
+    CatalogFileRecord file(const uint64_t fileIndex) const
+    {
+      if (fileIndex >= file_count_) {
+        throw std::logic_error("Catalog file is corrupt");
+      }
+      return read<CatalogFileRecord>(files_offset_ + fileIndex * sizeof(CatalogFileRecord));
+    }
+
+    CatalogObjectRecord object(const uint64_t objectIndex) const
+    {
+      if (objectIndex >= object_count_) {
+        throw std::logic_error("Catalog file is corrupt");
+      }
+      const CatalogObjectRecord object = read<CatalogObjectRecord>(objects_offset_ + objectIndex * sizeof(CatalogObjectRecord));
+      if (object.subtree_end > object_count_) {
+        throw std::logic_error("Catalog file is corrupt");
+      }
+      return object;
+    }
+
+    std::string_view string(const uint64_t offset, const uint64_t size) const
+    {
+      if (offset > strings_size_ || size > strings_size_ - offset) {
+        throw std::logic_error("Catalog file is corrupt");
+      }
+      return std::string_view(reinterpret_cast<const char*>(file_.data() + strings_offset_ + offset), size_t(size));
+    }
+
+    /**
+     * @brief Get the objects having a property value using binary search over the index entries
+     * 
+     * @return object indices in ascending order
+     */
+    std::vector<uint64_t> find_objects(const std::string_view name, const std::string_view value) const
+    {
+      uint64_t low{ 0 };
+      uint64_t high{ entry_count_ };
+      while (low < high) {
+        const uint64_t middle = low + (high - low) / 2;
+        const CatalogEntryRecord entry = read<CatalogEntryRecord>(entries_offset_ + middle * sizeof(CatalogEntryRecord));
+        const auto entryKey = std::make_pair(string(entry.name_offset, entry.name_size), string(entry.value_offset, entry.value_size));
+        if (entryKey < std::make_pair(name, value)) {
+          low = middle + 1;
+        }
+        else {
+          high = middle;
+        }
+      }
+      std::vector<uint64_t> objectIndices;
+      if (low < entry_count_) {
+        const CatalogEntryRecord entry = read<CatalogEntryRecord>(entries_offset_ + low * sizeof(CatalogEntryRecord));
+        if (name == string(entry.name_offset, entry.name_size) && value == string(entry.value_offset, entry.value_size)) {
+          if (entry.first_posting > posting_count_ || entry.posting_count > posting_count_ - entry.first_posting) {
+            throw std::logic_error("Catalog file is corrupt");
+          }
+          objectIndices.resize(size_t(entry.posting_count));
+          std::memcpy(objectIndices.data(), file_.data() + postings_offset_ + entry.first_posting * sizeof(uint64_t), objectIndices.size() * sizeof(uint64_t));
+        }
+      }
+      return objectIndices;
+    }
+
+  private:
+    template<class T> T read(const uint64_t offset) const
+    {
+      T value;
+      std::memcpy(&value, file_.data() + offset, sizeof(T));
+      return value;
+    }
+
+    MappedFile file_;
+    uint64_t file_count_{ 0 };
+    uint64_t object_count_{ 0 };
+    uint64_t posting_count_{ 0 };
+    uint64_t entry_count_{ 0 };
+    uint64_t strings_size_{ 0 };
+    uint64_t files_offset_{ 0 };
+    uint64_t objects_offset_{ 0 };
+    uint64_t postings_offset_{ 0 };
+    uint64_t entries_offset_{ 0 };
+    uint64_t strings_offset_{ 0 };
+  };
+
+  /**
+   * @brief Print the channels of a catalog matching all property conditions and overlapping a
+   *        time range. A property of a file or group applies to all of its channels. Values that
+   *        are numbers also match numeric properties written differently, e.g. 7.0 matches 7.
+   * 
+   * @param catalogFilePath  path of the catalog file
+   * @param conditions       NAME=VALUE pairs
+   * @param from             start of the time range in unix seconds
+   * @param to               end of the time range in unix seconds
+   * @return number of matching channels
+   */
+  uint64_t query_tdms_catalog(const std::string& catalogFilePath, const std::vector<std::string>& conditions, const double from, const double to)
+  {
+    const TdmsCatalog catalog(catalogFilePath);
+    const auto channels_below = [&catalog](const std::vector<uint64_t>& objectIndices) {
+      std::vector<uint64_t> channelIndices;
+      for (const auto objectIndex : objectIndices) {
+        const uint64_t subtreeEnd = catalog.object(objectIndex).subtree_end;
+        for (uint64_t channelIndex = objectIndex; channelIndex < subtreeEnd; ++channelIndex) {
+          if (catalogObjectKindChannel == catalog.object(channelIndex).kind) {
+            channelIndices.push_back(channelIndex);
+          }
+        }
+      }
+      std::sort(channelIndices.begin(), channelIndices.end());
+      channelIndices.erase(std::unique(channelIndices.begin(), channelIndices.end()), channelIndices.end());
+      return channelIndices;
+    };
+
+    std::vector<uint64_t> matches;
+    for (uint64_t objectIndex = 0; conditions.empty() && objectIndex < catalog.object_count(); ++objectIndex) {
+      if (catalogObjectKindChannel == catalog.object(objectIndex).kind) {
+        matches.push_back(objectIndex);
+      }
+    }
+    for (size_t conditionIndex = 0; conditionIndex < conditions.size(); ++conditionIndex) {
+      const std::string& condition = conditions[conditionIndex];
+      const size_t separator = condition.find('=');
+      if (std::string::npos == separator) {
+        throw std::logic_error("Condition has to be given as NAME=VALUE");
+      }
+      const std::string name = condition.substr(0, separator);
+      const std::string value = condition.substr(separator + 1);
+      std::vector<uint64_t> objectIndices = catalog.find_objects(name, value);
+      char* numberEnd = nullptr;
+      const double number = std::strtod(value.c_str(), &numberEnd);
+      if (!value.empty() && '\0' == *numberEnd) {
+        PropertyValue numericValue;
+        numericValue.datatype_ = tdmsTypeDoubleFloat;
+        numericValue.number_ = number;
+        const std::string canonicalValue = format_property_value(numericValue);
+        if (canonicalValue != value) {
+          const std::vector<uint64_t> canonicalIndices = catalog.find_objects(name, canonicalValue);
+          objectIndices.insert(objectIndices.end(), canonicalIndices.begin(), canonicalIndices.end());
+        }
+      }
+      const std::vector<uint64_t> channelIndices = channels_below(objectIndices);
+      if (0 == conditionIndex) {
+        matches = channelIndices;
+      }
+      else {
+        std::vector<uint64_t> intersection;
+        std::set_intersection(matches.begin(), matches.end(), channelIndices.begin(), channelIndices.end(), std::back_inserter(intersection));
+        matches.swap(intersection);
+      }
+    }
+
+    uint64_t matchCount{ 0 };
+    for (const auto channelIndex : matches) {
+      const CatalogObjectRecord channel = catalog.object(channelIndex);
+      const bool timeFiltered = !std::isinf(from) || !std::isinf(to);
+      if (timeFiltered && (std::isnan(channel.first_time) || channel.last_time < from || channel.first_time > to)) {
+        continue;
+      }
+      const CatalogFileRecord file = catalog.file(channel.file_index);
+      std::cout << catalog.string(file.path_offset, file.path_size) << "\t" << catalog.string(channel.path_offset, channel.path_size) << "\t"
+        << get_tdms_data_type_as_string(tdmsDataType(channel.datatype)) << "\t" << channel.number_of_values << "\t"
+        << format_double(channel.first_time) << "\t" << format_double(channel.last_time) << std::endl;
+      ++matchCount;
+    }
+    std::cout << matchCount << " channels" << std::endl;
+    return matchCount;
+  }
+
+#if defined(TDMS_INOTIFY)
+  /**
+   * @brief Keep the catalog of a directory tree up to date using inotify. Only files reported as
+   *        created, modified, closed or moved are indexed again. The layout of each file is kept
+   *        in memory, so a file that only grew is parsed starting at its first segment that was
+   *        not complete before. Changes are collected until the tree is quiet for a moment, at
+   *        most a second, and then written to the catalog at once.
+   */
+  class TdmsDirectoryWatcher
+  {
+  public:
+    TdmsDirectoryWatcher(const std::string& directory, const std::string& catalogFilePath, const unsigned threadCount, const bool useIndexFile = true) :
+      catalog_file_path_(catalogFilePath),
+      thread_count_(std::max(1U, threadCount)),
+      use_index_file_(useIndexFile)
+    {
+      inotify_ = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+      if (-1 == inotify_) {
+        throw std::logic_error("Failed to initialize inotify");
+      }
+      try {
+        add_directory(std::filesystem::u8path(directory));
+      }
+      catch (...) {
+        close(inotify_);
+        throw;
+      }
+    }
+
+    ~TdmsDirectoryWatcher()
+    {
+      close(inotify_);
+    }
+
+    TdmsDirectoryWatcher(const TdmsDirectoryWatcher&) = delete;
+    TdmsDirectoryWatcher& operator=(const TdmsDirectoryWatcher&) = delete;
+
+    /**
+     * @brief Index all files and watch for changes
+     * 
+     * @param idleExitSeconds  return after no change for this number of seconds, 0 to run forever
+     */
+    void run(const unsigned idleExitSeconds)
+    {
+      using Clock = std::chrono::steady_clock;
+      constexpr auto settleTime = std::chrono::milliseconds(100);
+      constexpr auto maximumDelay = std::chrono::milliseconds(1000);
+
+      update_files();
+      auto lastEvent = Clock::now();
+      auto firstPending = lastEvent;
+      for (;;) {
+        const auto now = Clock::now();
+        if (!dirty_.empty() && (now - lastEvent >= settleTime || now - firstPending >= maximumDelay)) {
+          update_files();
+          continue;
+        }
+        int timeout{ -1 };
+        if (!dirty_.empty()) {
+          timeout = int(std::chrono::duration_cast<std::chrono::milliseconds>(std::min(lastEvent + settleTime, firstPending + maximumDelay) - now).count()) + 1;
+        }
+        else if (0 != idleExitSeconds) {
+          const auto idleEnd = lastEvent + std::chrono::seconds(idleExitSeconds);
+          if (now >= idleEnd) {
+            return;
+          }
+          timeout = int(std::chrono::duration_cast<std::chrono::milliseconds>(idleEnd - now).count()) + 1;
+        }
+        pollfd pollFd{ inotify_, POLLIN, 0 };
+        const int ready = poll(&pollFd, 1, timeout);
+        if (-1 == ready && EINTR != errno) {
+          throw std::logic_error("Failed to wait for inotify events");
+        }
+        if (ready > 0) {
+          const bool wasClean = dirty_.empty();
+          if (read_events() > 0) {
+            lastEvent = Clock::now();
+            if (wasClean) {
+              firstPending = lastEvent;
+            }
+          }
+        }
+      }
+    }
+
+  private:
+    class WatchedFile
+    {
+    public:
+      FileIdentity identity_;
+      uint64_t first_segment_key_{ 0LL };
+      TdmsFileLayout layout_;
+      std::unique_ptr<CatalogFile> catalog_;
+    };
+
+    static bool is_tdms_file_path(const std::filesystem::path& path)
+    {
+      std::string extension = path.extension().u8string();
+      std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c) { return char(std::tolower(c)); });
+      return ".tdms" == extension;
+    }
+
+    /**
+     * @brief Watch a directory and all directories below it. Files already in it are indexed
+     *        with the next update, this also covers files created before the watch was added.
+     */
+    void add_directory(const std::filesystem::path& directory)
+    {
+      const uint32_t mask = IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_DELETE_SELF | IN_ONLYDIR;
+      const int watch = inotify_add_watch(inotify_, directory.c_str(), mask);
+      if (-1 == watch) {
+        if (directories_.empty()) {
+          throw std::logic_error("Failed to watch directory " + directory.u8string());
+        }
+        // e.g. removed again or out of watches, see /proc/sys/fs/inotify/max_user_watches
+        std::cerr << "EXCEPTION: Failed to watch directory " << directory.u8string() << std::endl;
+        return;
+      }
+      directories_[watch] = directory;
+      std::error_code errorCode;
+      for (const auto& entry : std::filesystem::directory_iterator(directory, std::filesystem::directory_options::skip_permission_denied, errorCode)) {
+        if (entry.is_directory(errorCode) && !entry.is_symlink(errorCode)) {
+          add_directory(entry.path());
+        }
+        else if (is_tdms_file_path(entry.path()) && entry.is_regular_file(errorCode)) {
+          dirty_.insert(entry.path().u8string());
+        }
+      }
+    }
+
+    /**
+     * @brief Read the pending inotify events
+     * 
+     * @return number of events concerning tdms files or directories
+     */
+    size_t read_events()
+    {
+      alignas(inotify_event) char buffer[64 * 1024];
+      size_t relevantCount{ 0 };
+      for (;;) {
+        const ssize_t readSize = read(inotify_, buffer, sizeof(buffer));
+        if (readSize <= 0) {
+          return relevantCount;
+        }
+        for (ssize_t offset = 0; offset < readSize;) {
+          const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+          offset += ssize_t(sizeof(inotify_event) + event->len);
+          if (0 != (event->mask & IN_Q_OVERFLOW)) {
+            // events were lost, compare all files with their last known state
+            for (const auto& file : files_) {
+              dirty_.insert(file.first);
+            }
+            const auto directories = directories_;
+            for (const auto& directory : directories) {
+              add_directory(directory.second);
+            }
+            ++relevantCount;
+            continue;
+          }
+          const auto directory = directories_.find(event->wd);
+          if (directories_.end() == directory) {
+            continue;
+          }
+          if (0 != (event->mask & IN_IGNORED)) {
+            directories_.erase(directory);
+            continue;
+          }
+          if (0 == event->len) {
+            continue;
+          }
+          const std::filesystem::path path = directory->second / std::filesystem::path(event->name);
+          if (0 != (event->mask & IN_ISDIR)) {
+            if (0 != (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+              add_directory(path);
+            }
+            else if (0 != (event->mask & (IN_DELETE | IN_MOVED_FROM))) {
+              // files below a removed directory are removed with the next update
+              const std::string prefix = path.u8string() + "/";
+              for (const auto& file : files_) {
+                if (0 == file.first.compare(0, prefix.size(), prefix)) {
+                  dirty_.insert(file.first);
+                }
+              }
+            }
+            ++relevantCount;
+          }
+          else if (is_tdms_file_path(path)) {
+            dirty_.insert(path.u8string());
+            ++relevantCount;
+          }
+        }
+      }
+    }
+
+    /**
+     * @brief Index a file again if it changed
+     * 
+     * @param useIndexFile  read the meta data from .tdms_index files if available
+     * @return description of the change, empty if the file did not change
+     */
+    static std::string update_file(const std::string& tdmsFilePath, WatchedFile& file, const bool useIndexFile)
+    {
+      const FileIdentity identity = get_file_identity(tdmsFilePath);
+      if (file.catalog_ && identity.size_ == file.identity_.size_ && identity.modification_time_ == file.identity_.modification_time_ &&
+        identity.inode_ == file.identity_.inode_ && identity.device_ == file.identity_.device_) {
+        return std::string();
+      }
+      const uint64_t firstSegmentKey = get_first_segment_key(tdmsFilePath);
+      const bool grew = file.catalog_ && identity.inode_ == file.identity_.inode_ && identity.device_ == file.identity_.device_ &&
+        identity.size_ >= file.identity_.size_ && firstSegmentKey == file.first_segment_key_;
+      const long resumedSegment = grew ? file.layout_.parse_state_.segment_index_ : 0;
+      file.catalog_.reset();
+      if (grew) {
+        ContentLoggerNull nl;
+        log_tdms_file_structure(tdmsFilePath, nl, &file.layout_);
+      }
+      else {
+        file.layout_ = read_tdms_file_layout(tdmsFilePath, useIndexFile);
+      }
+      file.catalog_.reset(new CatalogFile(read_catalog_file(tdmsFilePath, file.layout_)));
+      file.identity_ = identity;
+      file.first_segment_key_ = firstSegmentKey;
+      std::ostringstream description;
+      description << file.layout_.segments_.size() << " segments";
+      if (grew) {
+        description << ", resumed at segment " << resumedSegment;
+      }
+      return description.str();
+    }
+
+    /**
+     * @brief Index the changed files in parallel and write the catalog if anything changed
+     */
+    void update_files()
+    {
+      std::vector<std::pair<std::string, WatchedFile*>> updates;
+      bool changed{ false };
+      for (const auto& tdmsFilePath : dirty_) {
+        std::error_code errorCode;
+        if (std::filesystem::is_regular_file(std::filesystem::u8path(tdmsFilePath), errorCode)) {
+          updates.emplace_back(tdmsFilePath, &files_[tdmsFilePath]);
+        }
+        else if (0 != files_.erase(tdmsFilePath)) {
+          std::cout << tdmsFilePath << ": removed" << std::endl;
+          changed = true;
+        }
+      }
+      dirty_.clear();
+
+      std::mutex outputMutex;
+      std::atomic<size_t> nextFile{ 0 };
+      std::atomic<bool> updated{ false };
+      const auto worker = [&]() {
+        for (size_t updateIndex = nextFile++; updateIndex < updates.size(); updateIndex = nextFile++) {
+          const std::string& tdmsFilePath = updates[updateIndex].first;
+          try {
+            const std::string description = update_file(tdmsFilePath, *updates[updateIndex].second, use_index_file_);
+            if (!description.empty()) {
+              updated = true;
+              std::lock_guard<std::mutex> lock(outputMutex);
+              std::cout << tdmsFilePath << ": " << description << std::endl;
+            }
+          }
+          catch (const std::exception& ex) {
+            // the file is indexed from the start with its next change
+            *updates[updateIndex].second = WatchedFile();
+            updated = true;
+            std::lock_guard<std::mutex> lock(outputMutex);
+            std::cerr << "EXCEPTION: " << tdmsFilePath << ": " << ex.what() << std::endl;
+          }
+        }
+      };
+      std::vector<std::thread> threads;
+      for (unsigned threadIndex = 1; threadIndex < std::min<size_t>(thread_count_, updates.size()); ++threadIndex) {
+        threads.emplace_back(worker);
+      }
+      worker();
+      for (auto& thread : threads) {
+        thread.join();
+      }
+
+      if (changed || updated || !catalog_written_) {
+        std::vector<const CatalogFile*> catalogFiles;
+        for (const auto& file : files_) {
+          if (file.second.catalog_) {
+            catalogFiles.push_back(file.second.catalog_.get());
+          }
+        }
+        write_tdms_catalog_file(catalog_file_path_, catalogFiles);
+        catalog_written_ = true;
+      }
+    }
+
+    std::string catalog_file_path_;
+    unsigned thread_count_{ 1 };
+    bool use_index_file_{ true };
+    int inotify_{ -1 };
+    std::map<int, std::filesystem::path> directories_;
+    // ordered by path so the catalog does not depend on the order of the events
+    std::map<std::string, WatchedFile> files_;
+    std::set<std::string> dirty_;
+    bool catalog_written_{ false };
+  };
+#endif
+
+#if defined(TDMS_SOCKET)
+  /**
+   * @brief Parsed model of a tdms file kept by TdmsModelCache
+   */
+  class TdmsModel
+  {
+  public:
+    class Channel
+    {
+    public:
+      std::string path_;
+      tdmsDataType datatype_{ tdmsTypeVoid };
+      uint64_t number_of_values_{ 0LL };
+    };
+
+    FileIdentity identity_;
+    TdmsFileLayout layout_;
+    // structure xml as written by the default mode
+    std::string structure_;
+    std::vector<Channel> channels_;
+  };
+
+  /**
+   * @brief Thread safe LRU cache of parsed tdms files. A model is used as long as size and
+   *        modification time of the file do not change. Requests for a file that is being parsed
+   *        wait for this parse instead of starting another one.
+   */
+  class TdmsModelCache
+  {
+  public:
+    explicit TdmsModelCache(const size_t capacity, const bool useIndexFile = true) :
+      capacity_(std::max<size_t>(1, capacity)), use_index_file_(useIndexFile)
+    {
+    }
+
+    /**
+     * @brief Get the model of a file, parse it if it is not cached or outdated
+     */
+    std::shared_ptr<const TdmsModel> get(const std::string& tdmsFilePath)
+    {
+      const FileIdentity identity = get_file_identity(std::filesystem::u8path(tdmsFilePath));
+      std::promise<std::shared_ptr<const TdmsModel>> promise;
+      std::shared_future<std::shared_ptr<const TdmsModel>> future;
+      bool startParse{ false };
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto model = models_.find(tdmsFilePath);
+        if (models_.end() != model && is_same_file_version(model->second.first->identity_, identity)) {
+          lru_.splice(lru_.begin(), lru_, model->second.second);
+          ++hit_count_;
+          return model->second.first;
+        }
+        const auto parse = parses_.find(tdmsFilePath);
+        if (parses_.end() != parse) {
+          ++shared_count_;
+          future = parse->second;
+        }
+        else {
+          ++miss_count_;
+          future = promise.get_future().share();
+          parses_.emplace(tdmsFilePath, future);
+          startParse = true;
+        }
+      }
+      if (startParse) {
+        std::shared_ptr<const TdmsModel> model;
+        try {
+          model = parse_model(tdmsFilePath, identity, use_index_file_);
+        }
+        catch (...) {
+          promise.set_exception(std::current_exception());
+        }
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          parses_.erase(tdmsFilePath);
+          if (model) {
+            insert(tdmsFilePath, model);
+          }
+        }
+        if (model) {
+          promise.set_value(model);
+        }
+      }
+      return future.get();
+    }
+
+    /**
+     * @brief Get the cache counters as lines of name and value
+     */
+    std::string statistics()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::ostringstream ost;
+      ost << "cached\t" << models_.size() << "\n" << "hits\t" << hit_count_ << "\n" << "misses\t" << miss_count_ << "\n"
+        << "shared\t" << shared_count_ << "\n";
+      return ost.str();
+    }
+
+  private:
+    static bool is_same_file_version(const FileIdentity& lhs, const FileIdentity& rhs)
+    {
+      return lhs.size_ == rhs.size_ && lhs.modification_time_ == rhs.modification_time_ && lhs.inode_ == rhs.inode_ && lhs.device_ == rhs.device_;
+    }
+
+    static std::shared_ptr<const TdmsModel> parse_model(const std::string& tdmsFilePath, const FileIdentity& identity, const bool useIndexFile)
+    {
+      std::shared_ptr<TdmsModel> model = std::make_shared<TdmsModel>();
+      model->identity_ = identity;
+      std::ostringstream structure;
+      structure << R"(<?xml version="1.0" encoding="UTF-8" standalone="no" ?>)" << std::endl;
+      ContentLoggerXml structLog(structure, 0);
+      log_tdms_file_structure(tdmsFilePath, structLog, &model->layout_, nullptr, useIndexFile);
+      model->structure_ = structure.str();
+      std::map<std::string, size_t> channelIndices;
+      for (const auto& segment : model->layout_.segments_) {
+        for (const auto& channel : segment.channels_) {
+          const auto inserted = channelIndices.emplace(channel.rawInfo_.objPath_, model->channels_.size());
+          if (inserted.second) {
+            model->channels_.push_back(TdmsModel::Channel{ channel.rawInfo_.objPath_, channel.rawInfo_.value_datatype(), 0LL });
+          }
+          model->channels_[inserted.first->second].number_of_values_ += channel.rawInfo_.number_of_values_ * segment.number_of_chunks_;
+        }
+      }
+      return model;
+    }
+
+    void insert(const std::string& tdmsFilePath, const std::shared_ptr<const TdmsModel>& model)
+    {
+      const auto existing = models_.find(tdmsFilePath);
+      if (models_.end() != existing) {
+        lru_.erase(existing->second.second);
+        models_.erase(existing);
+      }
+      lru_.push_front(tdmsFilePath);
+      models_.emplace(tdmsFilePath, std::make_pair(model, lru_.begin()));
+      while (models_.size() > capacity_) {
+        models_.erase(lru_.back());
+        lru_.pop_back();
+      }
+    }
+
+    std::mutex mutex_;
+    size_t capacity_{ 1 };
+    bool use_index_file_{ true };
+    // most recently used first
+    std::list<std::string> lru_;
+    std::map<std::string, std::pair<std::shared_ptr<const TdmsModel>, std::list<std::string>::iterator>> models_;
+    std::map<std::string, std::shared_future<std::shared_ptr<const TdmsModel>>> parses_;
+    uint64_t hit_count_{ 0LL };
+    uint64_t miss_count_{ 0LL };
+    uint64_t shared_count_{ 0LL };
+  };
+
+  /**
+   * @brief Close a file descriptor when leaving the scope
+   */
+  class FileDescriptorGuard
+  {
+  public:
+    explicit FileDescriptorGuard(const int fileDescriptor) :
+      file_descriptor_(fileDescriptor)
+    {
+    }
+
+    ~FileDescriptorGuard()
+    {
+      close(file_descriptor_);
+    }
+
+    FileDescriptorGuard(const FileDescriptorGuard&) = delete;
+    FileDescriptorGuard& operator=(const FileDescriptorGuard&) = delete;
+
+  private:
+    int file_descriptor_;
+  };
+
+  /**
+   * @brief Write the values of a channel into a memory block of known size
+   */
+  class ChannelSinkMemory : public ChannelSink
+  {
+  public:
+    ChannelSinkMemory(uint8_t* data, const uint64_t capacity) :
+      data_(data), capacity_(capacity)
+    {
+    }
+
+    void append(const SgmtChannelLayout&, const uint8_t* values, const uint64_t byteCount, const uint64_t valueCount, const bool) override
+    {
+      if (size_ + byteCount > capacity_) {
+        throw std::logic_error("Memory block is too small");
+      }
+      std::memcpy(data_ + size_, values, size_t(byteCount));
+      size_ += byteCount;
+      number_of_values_ += valueCount;
+    }
+
+  private:
+    uint8_t* data_;
+    uint64_t capacity_;
+    uint64_t size_{ 0LL };
+    uint64_t number_of_values_{ 0LL };
+  };
+
+  /**
+   * @brief Create an anonymous shared memory block that can be passed to another process
+   * 
+   * @param size  size of the block in bytes
+   * @return file descriptor of the block
+   */
+  int create_shared_memory(const uint64_t size)
+  {
+#if defined(__linux__)
+    const int sharedMemory = memfd_create("tdms_values", MFD_CLOEXEC);
+#else
+    const std::string name = "/tdms_values_" + std::to_string(getpid()) + "_" + std::to_string(std::random_device()());
+    const int sharedMemory = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (-1 != sharedMemory) {
+      shm_unlink(name.c_str());
+    }
+#endif
+    if (-1 == sharedMemory) {
+      throw std::logic_error("Failed to create shared memory");
+    }
+    if (0 != ftruncate(sharedMemory, off_t(size))) {
+      close(sharedMemory);
+      throw std::logic_error("Failed to resize shared memory");
+    }
+    return sharedMemory;
+  }
+
+  /**
+   * @brief Send a message over a unix domain socket, optionally passing a file descriptor with
+   *        its first bytes
+   */
+  void send_message(const int connection, const std::string& message, const int fileDescriptor = -1)
+  {
+    size_t sentSize{ 0 };
+    while (sentSize < message.size()) {
+      iovec data{ const_cast<char*>(message.data() + sentSize), message.size() - sentSize };
+      msghdr header{};
+      header.msg_iov = &data;
+      header.msg_iovlen = 1;
+      alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+      if (-1 != fileDescriptor && 0 == sentSize) {
+        header.msg_control = control;
+        header.msg_controllen = sizeof(control);
+        cmsghdr* controlHeader = CMSG_FIRSTHDR(&header);
+        controlHeader->cmsg_level = SOL_SOCKET;
+        controlHeader->cmsg_type = SCM_RIGHTS;
+        controlHeader->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(controlHeader), &fileDescriptor, sizeof(int));
+      }
+      const ssize_t sent = sendmsg(connection, &header, 0);
+      if (-1 == sent) {
+        if (EINTR == errno) {
+          continue;
+        }
+        throw std::logic_error("Failed to send message");
+      }
+      sentSize += size_t(sent);
+    }
+  }
+
+  /**
+   * @brief Buffered reader of a unix domain socket keeping a file descriptor passed with the data
+   */
+  class SocketReader
+  {
+  public:
+    // longest line accepted, protects against clients sending data without a newline
+    static constexpr size_t max_line_size = 64 * 1024;
+
+    explicit SocketReader(const int connection) :
+      connection_(connection)
+    {
+    }
+
+    ~SocketReader()
+    {
+      if (-1 != file_descriptor_) {
+        close(file_descriptor_);
+      }
+    }
+
+    SocketReader(const SocketReader&) = delete;
+    SocketReader& operator=(const SocketReader&) = delete;
+
+    /**
+     * @brief Read a line without the terminating newline
+     * 
+     * @return false if the connection was closed before a complete line
+     */
+    bool read_line(std::string& line)
+    {
+      for (size_t searchOffset = 0;;) {
+        const size_t newline = buffer_.find('\n', searchOffset);
+        if (std::string::npos != newline) {
+          line = buffer_.substr(0, newline);
+          buffer_.erase(0, newline + 1);
+          return true;
+        }
+        if (buffer_.size() > max_line_size) {
+          throw std::logic_error("Line is too long");
+        }
+        searchOffset = buffer_.size();
+        if (!receive()) {
+          return false;
+        }
+      }
+    }
+
+    /**
+     * @brief Check if a complete line was already received
+     */
+    bool has_line() const
+    {
+      return std::string::npos != buffer_.find('\n');
+    }
+
+    /**
+     * @brief Read a number of bytes
+     */
+    void read_bytes(std::string& bytes, const size_t size)
+    {
+      while (buffer_.size() < size) {
+        if (!receive()) {
+          throw std::logic_error("Connection closed");
+        }
+      }
+      bytes = buffer_.substr(0, size);
+      buffer_.erase(0, size);
+    }
+
+    /**
+     * @brief Take the file descriptor received with the data, -1 if none was received
+     */
+    int take_file_descriptor()
+    {
+      const int fileDescriptor = file_descriptor_;
+      file_descriptor_ = -1;
+      return fileDescriptor;
+    }
+
+  private:
+    bool receive()
+    {
+      char data[64 * 1024];
+      iovec dataVector{ data, sizeof(data) };
+      alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+      msghdr header{};
+      header.msg_iov = &dataVector;
+      header.msg_iovlen = 1;
+      header.msg_control = control;
+      header.msg_controllen = sizeof(control);
+      ssize_t received;
+      do {
+        received = recvmsg(connection_, &header, 0);
+      } while (-1 == received && EINTR == errno);
+      if (received <= 0) {
+        return false;
+      }
+      for (cmsghdr* controlHeader = CMSG_FIRSTHDR(&header); nullptr != controlHeader; controlHeader = CMSG_NXTHDR(&header, controlHeader)) {
+        if (SOL_SOCKET == controlHeader->cmsg_level && SCM_RIGHTS == controlHeader->cmsg_type) {
+          if (-1 != file_descriptor_) {
+            close(file_descriptor_);
+          }
+          std::memcpy(&file_descriptor_, CMSG_DATA(controlHeader), sizeof(int));
+        }
+      }
+      buffer_.append(data, size_t(received));
+      return true;
+    }
+
+    int connection_;
+    int file_descriptor_{ -1 };
+    std::string buffer_;
+  };
+
+  /**
+   * @brief Get a sockaddr_un for a socket path
+   */
+  sockaddr_un get_socket_address(const std::string& socketPath)
+  {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+      throw std::logic_error("Socket path is too long");
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    return address;
+  }
+
+  /**
+   * @brief Serve structure and extraction requests over a unix domain socket. Parsed files are
+   *        kept in a TdmsModelCache shared by all connections. Each request is a line of tab
+   *        separated fields, a connection may send any number of requests:
+   * 
+   *        structure   TDMSFILEPATH                          structure xml like the default mode
+   *        channels    TDMSFILEPATH                          lines of channel path, data type and number of values
+   *        properties  TDMSFILEPATH  OBJECTPATH              lines of property name and value
+   *        extract     TDMSFILEPATH  CHANNELPATH [FIRST END] values as double in shared memory
+   *        stats                                             lines of cache counters
+   *        shutdown                                          stop the server
+   * 
+   *        The response is "OK <size>" followed by a newline and size bytes of data, "ERROR
+   *        <message>" or for extract "SHM <values> <size>". The file descriptor of the shared
+   *        memory block is passed with the SHM line, the client maps it without copying the values.
+   * 
+   *        A worker thread is only bound to a connection while it serves one request. Between
+   *        requests the connection is polled together with the listening socket, so idle clients
+   *        do not block the workers. Connections idle for longer than idle_timeout and clients
+   *        stalling within a request for longer than receive_timeout are closed.
+   */
+  class TdmsStructureServer
+  {
+  public:
+    static constexpr auto idle_timeout = std::chrono::seconds(300);
+    static constexpr auto receive_timeout = std::chrono::seconds(10);
+
+    TdmsStructureServer(const std::string& socketPath, const unsigned threadCount, const size_t cacheCapacity, const bool useIndexFile = true) :
+      socket_path_(socketPath), thread_count_(std::max(1U, threadCount)), cache_(cacheCapacity, useIndexFile)
+    {
+      const sockaddr_un address = get_socket_address(socketPath);
+      // written by workers returning a connection to wake up the poll of run()
+      if (0 != pipe(wake_)) {
+        throw std::logic_error("Failed to create pipe");
+      }
+      fcntl(wake_[0], F_SETFL, O_NONBLOCK);
+      fcntl(wake_[1], F_SETFL, O_NONBLOCK);
+      fcntl(wake_[0], F_SETFD, FD_CLOEXEC);
+      fcntl(wake_[1], F_SETFD, FD_CLOEXEC);
+      listen_ = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (-1 == listen_) {
+        close(wake_[0]);
+        close(wake_[1]);
+        throw std::logic_error("Failed to create socket");
+      }
+      // replace the socket of a server that was not shut down
+      struct stat socketStat;
+      if (0 == lstat(socketPath.c_str(), &socketStat) && S_ISSOCK(socketStat.st_mode)) {
+        unlink(socketPath.c_str());
+      }
+      if (0 != bind(listen_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) || 0 != listen(listen_, SOMAXCONN)) {
+        close(listen_);
+        close(wake_[0]);
+        close(wake_[1]);
+        throw std::logic_error("Failed to listen on " + socketPath);
+      }
+    }
+
+    ~TdmsStructureServer()
+    {
+      close(listen_);
+      close(wake_[0]);
+      close(wake_[1]);
+      unlink(socket_path_.c_str());
+    }
+
+    TdmsStructureServer(const TdmsStructureServer&) = delete;
+    TdmsStructureServer& operator=(const TdmsStructureServer&) = delete;
+
+    /**
+     * @brief Accept connections until a shutdown request is received
+     */
+    void run()
+    {
+      using Clock = std::chrono::steady_clock;
+      std::signal(SIGPIPE, SIG_IGN);
+      std::vector<std::thread> workers;
+      for (unsigned threadIndex = 0; threadIndex < thread_count_; ++threadIndex) {
+        workers.emplace_back([this]() { serve_connections(); });
+      }
+      std::cout << "serving " << socket_path_ << std::endl;
+      std::vector<pollfd> pollFds;
+      while (!stopping_) {
+        pollFds.assign({ pollfd{ listen_, POLLIN, 0 }, pollfd{ wake_[0], POLLIN, 0 } });
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          const auto now = Clock::now();
+          for (auto idle = idle_.begin(); idle_.end() != idle;) {
+            if (now - idle->second >= idle_timeout) {
+              readers_.erase(idle->first);
+              close(idle->first);
+              idle = idle_.erase(idle);
+              continue;
+            }
+            pollFds.push_back(pollfd{ idle->first, POLLIN, 0 });
+            ++idle;
+          }
+        }
+        if (poll(pollFds.data(), nfds_t(pollFds.size()), 100) <= 0) {
+          continue;
+        }
+        if (0 != (pollFds[1].revents & POLLIN)) {
+          char wakeData[64];
+          while (read(wake_[0], wakeData, sizeof(wakeData)) > 0) {
+          }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (0 != (pollFds[0].revents & POLLIN)) {
+          const int connection = accept(listen_, nullptr, nullptr);
+          if (-1 != connection) {
+            // a client stalling within a request releases its worker after the timeout
+            timeval timeout{ time_t(receive_timeout.count()), 0 };
+            setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            readers_.emplace(connection, std::make_unique<SocketReader>(connection));
+            idle_.emplace(connection, Clock::now());
+          }
+        }
+        for (size_t pollIndex = 2; pollIndex < pollFds.size(); ++pollIndex) {
+          if (0 != pollFds[pollIndex].revents) {
+            idle_.erase(pollFds[pollIndex].fd);
+            pending_.push_back(pollFds[pollIndex].fd);
+            condition_.notify_one();
+          }
+        }
+      }
+      {
+        // wake up workers waiting for the rest of a request
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const int connection : active_) {
+          shutdown(connection, SHUT_RDWR);
+        }
+        condition_.notify_all();
+      }
+      for (auto& worker : workers) {
+        worker.join();
+      }
+      readers_.clear();
+      for (const int connection : pending_) {
+        close(connection);
+      }
+      for (const auto& idle : idle_) {
+        close(idle.first);
+      }
+    }
+
+  private:
+    void serve_connections()
+    {
+      for (;;) {
+        int connection;
+        SocketReader* reader;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          condition_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+          if (stopping_) {
+            return;
+          }
+          connection = pending_.front();
+          pending_.pop_front();
+          active_.insert(connection);
+          reader = readers_.at(connection).get();
+        }
+        bool keepConnection{ false };
+        bool shutdownRequested{ false };
+        try {
+          keepConnection = serve_request(connection, *reader, shutdownRequested);
+        }
+        catch (const std::exception&) {
+          // client went away while sending the response or sent a malformed request
+        }
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          active_.erase(connection);
+          if (shutdownRequested) {
+            // only now that the reply was sent, the other connections are shut down
+            stopping_ = true;
+            condition_.notify_all();
+          }
+          else if (keepConnection && !stopping_) {
+            // requests already received are served next, otherwise the connection is polled again
+            if (reader->has_line()) {
+              pending_.push_back(connection);
+              condition_.notify_one();
+            }
+            else {
+              idle_.emplace(connection, std::chrono::steady_clock::now());
+              const char wakeData{ 0 };
+              if (write(wake_[1], &wakeData, 1) < 0) {
+                // the pipe is full, run() is woken up anyway
+              }
+            }
+            continue;
+          }
+          readers_.erase(connection);
+        }
+        close(connection);
+      }
+    }
+
+    /**
+     * @brief Serve one request of a connection
+     * 
+     * @param shutdownRequested  set if the request was a shutdown that was answered
+     * @return false if the connection was closed by the client
+     */
+    bool serve_request(const int connection, SocketReader& reader, bool& shutdownRequested)
+    {
+      std::string line;
+      if (!reader.read_line(line)) {
+        return false;
+      }
+      std::vector<std::string> fields;
+      for (size_t begin = 0;;) {
+        const size_t end = line.find('\t', begin);
+        fields.push_back(line.substr(begin, end - begin));
+        if (std::string::npos == end) {
+          break;
+        }
+        begin = end + 1;
+      }
+      int sharedMemory{ -1 };
+      std::string response;
+      try {
+        response = handle_request(fields, sharedMemory);
+      }
+      catch (const std::exception& ex) {
+        std::string message(ex.what());
+        std::replace(message.begin(), message.end(), '\n', ' ');
+        response = "ERROR " + message + "\n";
+      }
+      try {
+        send_message(connection, response, sharedMemory);
+      }
+      catch (...) {
+        if (-1 != sharedMemory) {
+          close(sharedMemory);
+        }
+        throw;
+      }
+      if (-1 != sharedMemory) {
+        close(sharedMemory);
+      }
+      shutdownRequested = "shutdown" == fields[0];
+      return true;
+    }
+
+    std::string handle_request(const std::vector<std::string>& fields, int& sharedMemory)
+    {
+      const auto ok = [](const std::string& data) {
+        return "OK " + std::to_string(data.size()) + "\n" + data;
+      };
+      const std::string& command = fields[0];
+      if ("stats" == command) {
+        return ok(cache_.statistics());
+      }
+      if ("shutdown" == command) {
+        // the server stops in serve_connections once this reply was sent
+        return ok(std::string());
+      }
+      if ("structure" != command && "channels" != command && "properties" != command && "extract" != command) {
+        throw std::logic_error("Unknown request " + command);
+      }
+      if (fields.size() < 2) {
+        throw std::logic_error("Request needs a tdms file path");
+      }
+      const std::string& tdmsFilePath = fields[1];
+      const std::shared_ptr<const TdmsModel> model = cache_.get(tdmsFilePath);
+      if ("structure" == command) {
+        return ok(model->structure_);
+      }
+      if ("channels" == command) {
+        std::ostringstream ost;
+        for (const auto& channel : model->channels_) {
+          ost << channel.path_ << "\t" << get_tdms_data_type_as_string(channel.datatype_) << "\t" << channel.number_of_values_ << "\n";
+        }
+        return ok(ost.str());
+      }
+      if (fields.size() < 3) {
+        throw std::logic_error("Request needs an object path");
+      }
+      const std::string& objPath = fields[2];
+      if ("properties" == command) {
+        std::ostringstream ost;
+        const ObjectProperties* properties = model->layout_.find_properties(objPath);
+        if (nullptr == properties) {
+          throw std::logic_error("Unknown object " + objPath);
+        }
+        for (const auto& property : *properties) {
+          ost << property.first << "\t" << format_property_value(property.second) << "\n";
+        }
+        return ok(ost.str());
+      }
+
+      const auto channel = std::find_if(model->channels_.begin(), model->channels_.end(), [&objPath](const TdmsModel::Channel& candidate) {
+        return candidate.path_ == objPath;
+      });
+      if (model->channels_.end() == channel) {
+        throw std::logic_error("Unknown channel " + objPath);
+      }
+      if (!is_tdms_data_type_numeric(channel->datatype_) && tdmsTypeTimeStamp != channel->datatype_) {
+        throw std::logic_error("Channel can not be converted to double");
+      }
+      const ChannelSampleIndex index(model->layout_, objPath);
+      const uint64_t first = fields.size() > 3 ? std::stoull(fields[3]) : 0LL;
+      const uint64_t end = fields.size() > 4 ? std::stoull(fields[4]) : index.size();
+      if (first > end || end > index.size()) {
+        throw std::logic_error("Sample range out of range");
+      }
+      const uint64_t byteCount = (end - first) * sizeof(double);
+      sharedMemory = create_shared_memory(byteCount);
+      try {
+        if (0 != byteCount) {
+          void* data = mmap(nullptr, size_t(byteCount), PROT_READ | PROT_WRITE, MAP_SHARED, sharedMemory, 0);
+          if (MAP_FAILED == data) {
+            throw std::logic_error("Failed to map shared memory");
+          }
+          try {
+            FileIo fileIo(tdmsFilePath);
+            ChannelExtractor extractor(fileIo, model->layout_);
+            ChannelSinkMemory memorySink(static_cast<uint8_t*>(data), byteCount);
+            ChannelSinkFloatingPoint<double> sink(memorySink);
+            extractor.extract_range(index, first, end, sink);
+          }
+          catch (...) {
+            munmap(data, size_t(byteCount));
+            throw;
+          }
+          munmap(data, size_t(byteCount));
+        }
+      }
+      catch (...) {
+        close(sharedMemory);
+        sharedMemory = -1;
+        throw;
+      }
+      return "SHM " + std::to_string(end - first) + " " + std::to_string(byteCount) + "\n";
+    }
+
+    std::string socket_path_;
+    unsigned thread_count_{ 1 };
+    TdmsModelCache cache_;
+    int listen_{ -1 };
+    int wake_[2]{ -1, -1 };
+    std::atomic<bool> stopping_{ false };
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    // connections with a request to serve
+    std::list<int> pending_;
+    // connections being served by a worker
+    std::set<int> active_;
+    // connections waiting for their next request and when they became idle
+    std::map<int, std::chrono::steady_clock::time_point> idle_;
+    // keeps data received beyond the current request while a connection is idle
+    std::map<int, std::unique_ptr<SocketReader>> readers_;
+  };
+
+  /**
+   * @brief Send a request to a TdmsStructureServer and print the response. Values received in
+   *        shared memory are written to a binary file if given.
+   * 
+   * @param socketPath      path of the server socket
+   * @param fields          request and its arguments
+   * @param binFilePath     file receiving the values of an extract request, may be empty
+   */
+  void request_tdms_structure_server(const std::string& socketPath, const std::vector<std::string>& fields, const std::string& binFilePath)
+  {
+    const sockaddr_un address = get_socket_address(socketPath);
+    const int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (-1 == connection) {
+      throw std::logic_error("Failed to create socket");
+    }
+    const FileDescriptorGuard connectionGuard(connection);
+    if (0 != connect(connection, reinterpret_cast<const sockaddr*>(&address), sizeof(address))) {
+      throw std::logic_error("Failed to connect to " + socketPath);
+    }
+    std::string request;
+    for (const auto& field : fields) {
+      request += (request.empty() ? "" : "\t") + field;
+    }
+    send_message(connection, request + "\n");
+
+    SocketReader reader(connection);
+    std::string line;
+    if (!reader.read_line(line)) {
+      throw std::logic_error("Connection closed");
+    }
+    if (0 == line.compare(0, 6, "ERROR ")) {
+      throw std::logic_error(line.substr(6));
+    }
+    std::istringstream header(line);
+    std::string kind;
+    header >> kind;
+    if ("OK" == kind) {
+      size_t size{ 0 };
+      header >> size;
+      std::string data;
+      reader.read_bytes(data, size);
+      std::cout << data;
+      return;
+    }
+    if ("SHM" != kind) {
+      throw std::logic_error("Unexpected response " + line);
+    }
+    uint64_t valueCount{ 0 };
+    uint64_t byteCount{ 0 };
+    header >> valueCount >> byteCount;
+    const int sharedMemory = reader.take_file_descriptor();
+    if (-1 == sharedMemory) {
+      throw std::logic_error("No shared memory received");
+    }
+    const FileDescriptorGuard sharedMemoryGuard(sharedMemory);
+    if (!binFilePath.empty()) {
+      std::ofstream ofs(std::filesystem::u8path(binFilePath), std::ios::binary | std::ios::out | std::ios::trunc);
+      if (!ofs) {
+        throw std::logic_error("Failed to create file");
+      }
+      if (0 != byteCount) {
+        const void* data = mmap(nullptr, size_t(byteCount), PROT_READ, MAP_SHARED, sharedMemory, 0);
+        if (MAP_FAILED == data) {
+          throw std::logic_error("Failed to map shared memory");
+        }
+        ofs.write(static_cast<const char*>(data), std::streamsize(byteCount));
+        munmap(const_cast<void*>(data), size_t(byteCount));
+      }
+      if (!ofs) {
+        throw std::logic_error("Failed to write bytes");
+      }
+    }
+    std::cout << valueCount << " values in shared memory" << std::endl;
+  }
+#endif
+
+  /**
+   * @brief Write the index file of a tdms file. Only lead ins and meta data are read from the tdms
+   *        file and written unchanged except for the tag TDSh, which is the layout NI writers use
+   *        for .tdms_index files.
+   * 
+   * @param tdmsFilePath   path of the tdms file
+   * @param indexFilePath  path of the index file to write. Next to the tdms file if empty.
+   */
+  void write_tdms_index_file(const std::string& tdmsFilePath, std::string indexFilePath)
+  {
+    constexpr size_t leadInSizeInByte{ sizeof(SgmtHeader) + sizeof(uint32_t) + 2 * sizeof(uint64_t) };
+    if (indexFilePath.empty()) {
+      indexFilePath = get_tdms_index_file_path(tdmsFilePath).u8string();
+    }
+    FileIo fileIo(tdmsFilePath);
+    const uint64_t fileSize = fileIo.size();
+    std::vector<uint8_t> index;
+    uint64_t segmentOffset{ 0 };
+    long segmentCount{ 0 };
+    while (segmentOffset < fileSize) {
+      uint8_t leadIn[leadInSizeInByte];
+      fileIo.seek(segmentOffset);
+      if (!fileIo.read_no_throw(leadIn, leadInSizeInByte)) {
+        throw std::logic_error("Lead in exceeds the file size");
+      }
+      if (0 != std::memcmp(leadIn, "TDSm", 4)) {
+        throw std::logic_error("Segment always starts with TDSm");
+      }
+      SgmtHeader sgmtHeader;
+      std::memcpy(&sgmtHeader, leadIn, sizeof(SgmtHeader));
+      const bool bigEndian = sgmtHeader.toc.BigEndian;
+      if (0x1269 != decode_lead_in_value(leadIn + 8, 4, bigEndian)) {
+        throw std::logic_error("Only TDMS 2.0 supported by this code");
+      }
+      const uint64_t nextSegmentOffset = decode_lead_in_value(leadIn + 12, 8, bigEndian);
+      const uint64_t rawDataOffset = decode_lead_in_value(leadIn + 20, 8, bigEndian);
+      const uint64_t segmentEnd = 0xFFFFFFFFFFFFFFFFULL == nextSegmentOffset ? fileSize : segmentOffset + leadInSizeInByte + nextSegmentOffset;
+      if (segmentEnd > fileSize || segmentOffset + leadInSizeInByte + rawDataOffset > segmentEnd) {
+        throw std::logic_error("Segment exceeds the file size");
+      }
+
+      const size_t indexOffset = index.size();
+      index.resize(indexOffset + leadInSizeInByte + rawDataOffset);
+      std::memcpy(index.data() + indexOffset, leadIn, leadInSizeInByte);
+      index[indexOffset + 3] = 'h';
+      fileIo.read_bytes(index.data() + indexOffset + leadInSizeInByte, rawDataOffset);
+      segmentOffset = segmentEnd;
+      ++segmentCount;
+    }
+
+    // replace the index at once so readers never take a partially written index for consistent
+    const std::filesystem::path fsIndexFilePath = std::filesystem::u8path(indexFilePath);
+    std::filesystem::path temporaryFilePath = fsIndexFilePath;
+    temporaryFilePath += "." + std::to_string(std::random_device()()) + ".tmp";
+    {
+      std::ofstream ofs(temporaryFilePath, std::ios::binary | std::ios::out | std::ios::trunc);
+      ofs.write(reinterpret_cast<const char*>(index.data()), std::streamsize(index.size()));
+      ofs.close();
+      if (!ofs) {
+        std::error_code errorCode;
+        std::filesystem::remove(temporaryFilePath, errorCode);
+        throw std::logic_error("Failed to write index file");
+      }
+    }
+    std::filesystem::rename(temporaryFilePath, fsIndexFilePath);
+    std::cout << tdmsFilePath << " -> " << indexFilePath << " (" << segmentCount << " segments)" << std::endl;
+  }
+
+  /**
+   * @brief Bits of the table of contents of a segment lead in
+   */
+  constexpr uint32_t toc_meta_data{ 1U << 1 };
+  constexpr uint32_t toc_new_obj_list{ 1U << 2 };
+  constexpr uint32_t toc_raw_data{ 1U << 3 };
+  constexpr uint32_t toc_big_endian{ 1U << 6 };
+
+  /**
+   * @brief Collect the meta data of a segment in the byte order of the operating system
+   */
+  class SgmtMetaDataWriter
+  {
+  public:
+    template<class T> void write_value(const T& value)
+    {
+      static_assert(std::is_trivially_copyable<T>::value, "only plain values can be written");
+      const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+      buffer_.insert(buffer_.end(), bytes, bytes + sizeof(T));
+    }
+
+    void write_string(const std::string& value)
+    {
+      write_value(uint32_t(value.size()));
+      buffer_.insert(buffer_.end(), value.begin(), value.end());
+    }
+
+    /**
+     * @brief Write the raw data index of a channel
+     * 
+     * @param datatype         data type of the values
+     * @param numberOfValues   number of values of the channel in a chunk
+     * @param totalSizeInByte  size of the offsets and utf8 data, only written for strings
+     */
+    void write_raw_data_index(const tdmsDataType datatype, const uint64_t numberOfValues, const uint64_t totalSizeInByte)
+    {
+      const bool isString = tdmsTypeString == datatype;
+      write_value(uint32_t(isString ? 0x1C : 0x14));
+      write_value(uint32_t(datatype));
+      write_value(uint32_t(1));
+      write_value(numberOfValues);
+      if (isString) {
+        write_value(totalSizeInByte);
+      }
+    }
+
+    /**
+     * @brief Write the properties of an object. A value whose bytes are not known throws instead
+     *        of silently dropping the property from the written file.
+     * 
+     * @param objPath     path of the object, used in the error message
+     * @param properties  properties of the object or nullptr
+     */
+    void write_properties(const std::string& objPath, const ObjectProperties* properties)
+    {
+      std::vector<const ObjectProperties::value_type*> writable;
+      if (nullptr != properties) {
+        for (const auto& property : *properties) {
+          if (tdmsTypeString != property.second.datatype_ && property.second.raw_.empty()) {
+            throw std::logic_error("Value of property " + property.first + " of object " + objPath + " can not be written");
+          }
+          writable.push_back(&property);
+        }
+      }
+      write_value(uint32_t(writable.size()));
+      for (const auto property : writable) {
+        write_string(property->first);
+        write_value(uint32_t(property->second.datatype_));
+        if (tdmsTypeString == property->second.datatype_) {
+          write_string(property->second.string_);
+        }
+        else {
+          buffer_.insert(buffer_.end(), property->second.raw_.begin(), property->second.raw_.end());
+        }
+      }
+    }
+
+    const std::vector<uint8_t>& buffer() const
+    {
+      return buffer_;
+    }
+
+  private:
+    std::vector<uint8_t> buffer_;
+  };
+
+  /**
+   * @brief Remove a temporary file when leaving the scope unless it was kept, e.g. because it
+   *        was renamed to its final path
+   */
+  class TemporaryFileGuard
+  {
+  public:
+    explicit TemporaryFileGuard(const std::filesystem::path& filePath) :
+      file_path_(filePath)
+    {
+    }
+
+    ~TemporaryFileGuard()
+    {
+      if (!kept_) {
+        std::error_code errorCode;
+        std::filesystem::remove(file_path_, errorCode);
+      }
+    }
+
+    TemporaryFileGuard(const TemporaryFileGuard&) = delete;
+    TemporaryFileGuard& operator=(const TemporaryFileGuard&) = delete;
+
+    void keep()
+    {
+      kept_ = true;
+    }
+
+  private:
+    std::filesystem::path file_path_;
+    bool kept_{ false };
+  };
+
+  /**
+   * @brief Write the lead in of a segment. The table of contents is little endian, all other
+   *        values are in the byte order of the operating system, which is flagged in the table
+   *        of contents.
+   * 
+   * @param os            stream the lead in is written to
+   * @param toc           table of contents without the big endian flag
+   * @param metaDataSize  number of bytes of the meta data following the lead in
+   * @param rawDataSize   number of bytes of the raw data following the meta data
+   */
+  void write_segment_lead_in(std::ostream& os, uint32_t toc, const uint64_t metaDataSize, const uint64_t rawDataSize)
+  {
+    if (SgmtFileIo::is_big_endian_os()) {
+      toc |= toc_big_endian;
+    }
+    const uint32_t version{ 4713 };
+    const uint64_t nextSegmentOffset = metaDataSize + rawDataSize;
+    uint8_t leadIn[28];
+    std::memcpy(leadIn, "TDSm", 4);
+    for (int byteIndex = 0; byteIndex < 4; ++byteIndex) {
+      leadIn[4 + byteIndex] = uint8_t(toc >> (8 * byteIndex));
+    }
+    std::memcpy(leadIn + 8, &version, sizeof(version));
+    std::memcpy(leadIn + 12, &nextSegmentOffset, sizeof(nextSegmentOffset));
+    std::memcpy(leadIn + 20, &metaDataSize, sizeof(metaDataSize));
+    if (!os.write(reinterpret_cast<const char*>(leadIn), sizeof(leadIn))) {
+      throw std::logic_error("Failed to write bytes");
+    }
+  }
+
+  /**
+   * @brief Rewrite a tdms file as few large segments. The first segment contains all objects with
+   *        the latest values of their properties. The raw data of each channel is stored as one
+   *        contiguous non interleaved block which is only split if it exceeds the segment size.
+   *        Small channels share a segment. Values are written in the byte order of the operating
+   *        system and DAQmx raw data is decoded to the data type of its first scaler.
+   * 
+   * @param tdmsFilePath       path of the tdms file
+   * @param outFilePath        path of the defragmented tdms file
+   * @param segmentSizeInByte  maximal size of the raw data of a segment. Exceeded only by a
+   *                           single value larger than it.
+   * @param useIndexFile       read the meta data from .tdms_index files if available
+   */
+  void defragment_tdms_file(const std::string& tdmsFilePath, const std::string& outFilePath, const uint64_t segmentSizeInByte, const bool useIndexFile = true)
+  {
+    if (0 == segmentSizeInByte || segmentSizeInByte > UINT32_MAX) {
+      throw std::logic_error("Segment size must be between 1 byte and 4 GiB");
+    }
+    const std::filesystem::path fsOutFilePath = std::filesystem::u8path(outFilePath);
+    std::error_code errorCode;
+    if (std::filesystem::equivalent(std::filesystem::u8path(tdmsFilePath), fsOutFilePath, errorCode)) {
+      throw std::logic_error("Defragmented file must not replace the tdms file");
+    }
+    const TdmsFileLayout layout = read_tdms_file_layout(tdmsFilePath, useIndexFile);
+
+    // channels in order of appearance
+    std::vector<std::string> channelPaths;
+    std::map<std::string, std::pair<tdmsDataType, uint64_t>> channels;
+    for (const auto& segment : layout.segments_) {
+      for (const auto& channel : segment.channels_) {
+        const auto inserted = channels.emplace(channel.rawInfo_.objPath_, std::make_pair(channel.rawInfo_.value_datatype(), 0ULL));
+        if (inserted.second) {
+          channelPaths.push_back(channel.rawInfo_.objPath_);
+        }
+        else if (inserted.first->second.first != channel.rawInfo_.value_datatype()) {
+          throw std::logic_error("Data type of channel " + channel.rawInfo_.objPath_ + " changes");
+        }
+        inserted.first->second.second += channel.rawInfo_.number_of_values_ * segment.number_of_chunks_;
+      }
+    }
+
+    // parents are listed before their children
+    std::vector<std::string> objectPaths{ "/" };
+    std::set<std::string> knownPaths{ "/" };
+    const auto add_object = [&](const std::string& objPath) {
+      const std::string parentPath = get_parent_object_path(objPath);
+      if (!parentPath.empty() && knownPaths.insert(parentPath).second) {
+        objectPaths.push_back(parentPath);
+      }
+      if (knownPaths.insert(objPath).second) {
+        objectPaths.push_back(objPath);
+      }
+    };
+    for (const auto& channelPath : channelPaths) {
+      add_object(channelPath);
+    }
+    for (const auto& objectProperties : layout.properties_) {
+      add_object(objectProperties.first);
+    }
+
+    // distribute the values to segments
+    struct Piece
+    {
+      std::string path_;
+      tdmsDataType datatype_;
+      uint64_t first_;
+      uint64_t end_;
+      uint64_t size_in_byte_;
+    };
+    std::vector<std::vector<Piece>> segments(1);
+    uint64_t segmentUsed{ 0 };
+    const auto add_piece = [&](const Piece& piece) {
+      if (!segments.back().empty() && segmentUsed + piece.size_in_byte_ > segmentSizeInByte) {
+        segments.emplace_back();
+        segmentUsed = 0;
+      }
+      segments.back().push_back(piece);
+      segmentUsed += piece.size_in_byte_;
+    };
+    std::unique_ptr<MappedFile> mappedFile;
+    std::map<std::string, StringChannelView> stringViews;
+    for (const auto& channelPath : channelPaths) {
+      const tdmsDataType datatype = channels[channelPath].first;
+      const uint64_t numberOfValues = channels[channelPath].second;
+      if (tdmsTypeString == datatype) {
+        if (!mappedFile) {
+          mappedFile.reset(new MappedFile(tdmsFilePath));
+        }
+        const StringChannelView& strings = stringViews.try_emplace(channelPath, *mappedFile, layout, channelPath).first->second;
+        uint64_t first{ 0 };
+        uint64_t pieceSize{ 0 };
+        for (uint64_t index = 0; index < numberOfValues; ++index) {
+          const uint64_t valueSize = sizeof(uint32_t) + strings.value(index).size();
+          if (index > first && pieceSize + valueSize > segmentSizeInByte) {
+            add_piece(Piece{ channelPath, datatype, first, index, pieceSize });
+            first = index;
+            pieceSize = 0;
+          }
+          pieceSize += valueSize;
+        }
+        if (first < numberOfValues) {
+          add_piece(Piece{ channelPath, datatype, first, numberOfValues, pieceSize });
+        }
+        continue;
+      }
+      const uint64_t valueSize = get_tdms_data_type_byte_size(datatype);
+      if (0 == valueSize) {
+        throw std::logic_error("Values of channel " + channelPath + " can not be written");
+      }
+      const uint64_t valuesPerPiece = std::max<uint64_t>(1, segmentSizeInByte / valueSize);
+      for (uint64_t first = 0; first < numberOfValues; first += valuesPerPiece) {
+        const uint64_t end = std::min(numberOfValues, first + valuesPerPiece);
+        add_piece(Piece{ channelPath, datatype, first, end, (end - first) * valueSize });
+      }
+    }
+
+    std::filesystem::path temporaryFilePath = fsOutFilePath;
+    temporaryFilePath += "." + std::to_string(std::random_device()()) + ".tmp";
+    // declared before the stream, so the file is closed before it is removed on errors
+    TemporaryFileGuard temporaryFileGuard(temporaryFilePath);
+    std::ofstream ofs(temporaryFilePath, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!ofs) {
+      throw std::logic_error("Failed to create file");
+    }
+    FileIo fileIo(tdmsFilePath);
+    ChannelExtractor extractor(fileIo, layout);
+    std::map<std::string, ChannelSampleIndex> indexes;
+    for (size_t segmentIndex = 0; segmentIndex < segments.size(); ++segmentIndex) {
+      const std::vector<Piece>& pieces = segments[segmentIndex];
+      SgmtMetaDataWriter metaData;
+      if (0 == segmentIndex) {
+        metaData.write_value(uint32_t(objectPaths.size()));
+        for (const auto& objPath : objectPaths) {
+          metaData.write_string(objPath);
+          const auto piece = std::find_if(pieces.begin(), pieces.end(), [&objPath](const Piece& piece) { return piece.path_ == objPath; });
+          if (pieces.end() == piece) {
+            metaData.write_value(uint32_t(0xFFFFFFFF));
+          }
+          else {
+            metaData.write_raw_data_index(piece->datatype_, piece->end_ - piece->first_, piece->size_in_byte_);
+          }
+          metaData.write_properties(objPath, layout.find_properties(objPath));
+        }
+      }
+      else {
+        metaData.write_value(uint32_t(pieces.size()));
+        for (const auto& piece : pieces) {
+          metaData.write_string(piece.path_);
+          metaData.write_raw_data_index(piece.datatype_, piece.end_ - piece.first_, piece.size_in_byte_);
+          metaData.write_value(uint32_t(0));
+        }
+      }
+      uint64_t rawDataSize{ 0 };
+      for (const auto& piece : pieces) {
+        rawDataSize += piece.size_in_byte_;
+      }
+      write_segment_lead_in(ofs, toc_meta_data | toc_new_obj_list | (0 == rawDataSize ? 0 : toc_raw_data), metaData.buffer().size(), rawDataSize);
+      ofs.write(reinterpret_cast<const char*>(metaData.buffer().data()), std::streamsize(metaData.buffer().size()));
+
+      for (const auto& piece : pieces) {
+        if (tdmsTypeString == piece.datatype_) {
+          const StringChannelView& strings = stringViews.at(piece.path_);
+          std::vector<uint32_t> offsets;
+          offsets.reserve(size_t(piece.end_ - piece.first_));
+          uint32_t offset{ 0 };
+          for (uint64_t index = piece.first_; index < piece.end_; ++index) {
+            offset += uint32_t(strings.value(index).size());
+            offsets.push_back(offset);
+          }
+          ofs.write(reinterpret_cast<const char*>(offsets.data()), std::streamsize(offsets.size() * sizeof(uint32_t)));
+          for (uint64_t index = piece.first_; index < piece.end_; ++index) {
+            const std::string_view value = strings.value(index);
+            ofs.write(value.data(), std::streamsize(value.size()));
+          }
+          continue;
+        }
+        const ChannelSampleIndex& index = indexes.try_emplace(piece.path_, layout, piece.path_).first->second;
+        ChannelSinkStream sink(ofs);
+        extractor.extract_range(index, piece.first_, piece.end_, sink);
+        if (sink.number_of_values() != piece.end_ - piece.first_) {
+          throw std::logic_error("Channel " + piece.path_ + " contains less values than expected");
+        }
+      }
+    }
+    ofs.close();
+    if (!ofs) {
+      throw std::logic_error("Failed to write bytes");
+    }
+    std::filesystem::rename(temporaryFilePath, fsOutFilePath);
+    temporaryFileGuard.keep();
+    std::cout << tdmsFilePath << " -> " << outFilePath << " (" << layout.segments_.size() << " segments rewritten as "
+      << segments.size() << ")" << std::endl;
+  }
+
+  /**
+   * @brief Transpose consecutive blocks of rows of an interleaved segment into the non
+   *        interleaved layout. Each block is written channel after channel. The rows are split
+   *        into jobs of a few MiB processed in parallel, deinterleave_rows keeps the rows of a
+   *        job in the cache while all channels consume them.
+   * 
+   * @param segment       interleaved segment the rows belong to
+   * @param src           first row of the first block
+   * @param dst           receives blockCount blocks of rowsPerBlock values of each channel
+   * @param blockCount    number of blocks
+   * @param rowsPerBlock  number of rows of each block
+   * @param threadCount   number of worker threads
+   */
+  void transpose_interleaved_rows(const SgmtLayout& segment, const uint8_t* src, uint8_t* dst, const uint64_t blockCount,
+    const uint64_t rowsPerBlock, const unsigned threadCount)
+  {
+    constexpr uint64_t jobSizeInByte{ 4 * 1024 * 1024 };
+    const uint64_t rowSize = segment.row_size();
+    const uint64_t rowsPerJob = std::max<uint64_t>(1, jobSizeInByte / rowSize);
+    const uint64_t jobsPerBlock = (rowsPerBlock + rowsPerJob - 1) / rowsPerJob;
+    const uint64_t jobCount = blockCount * jobsPerBlock;
+    std::atomic<uint64_t> nextJob{ 0 };
+    const auto worker = [&]() {
+      std::vector<DeinterleaveColumn> columns(segment.channels_.size());
+      for (uint64_t jobIndex = nextJob++; jobIndex < jobCount; jobIndex = nextJob++) {
+        const uint64_t blockIndex = jobIndex / jobsPerBlock;
+        const uint64_t firstRow = (jobIndex % jobsPerBlock) * rowsPerJob;
+        const uint64_t rowCount = std::min(rowsPerJob, rowsPerBlock - firstRow);
+        uint8_t* blockDst = dst + blockIndex * rowsPerBlock * rowSize;
+        for (size_t channelIndex = 0; channelIndex < columns.size(); ++channelIndex) {
+          const SgmtChannelLayout& channel = segment.channels_[channelIndex];
+          const uint64_t valueSize = channel.value_size();
+          columns[channelIndex] = DeinterleaveColumn{ channel.offset_in_chunk_, valueSize,
+            blockDst + rowsPerBlock * channel.offset_in_chunk_ + firstRow * valueSize };
+        }
+        deinterleave_rows(src + (blockIndex * rowsPerBlock + firstRow) * rowSize, rowSize, rowCount, columns);
+      }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned threadIndex = 1; threadIndex < std::min<uint64_t>(std::max(1U, threadCount), jobCount); ++threadIndex) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  /**
+   * @brief Rewrite a tdms file with the raw data of interleaved segments transposed into the non
+   *        interleaved layout. Lead ins and meta data are copied unchanged except for the
+   *        interleaved flag, so every segment keeps its position and the values of a channel in
+   *        a chunk become one contiguous block. No padding is inserted, values are only aligned
+   *        for their type if their offset in the file happens to be. DAQmx segments and segments
+   *        whose channels differ in their number of values are copied unchanged.
+   * 
+   * @param tdmsFilePath      path of the tdms file
+   * @param outFilePath       path of the converted tdms file
+   * @param threadCount       number of threads transposing the rows
+   * @param useIndexFile      read the meta data from .tdms_index files if available
+   * @param windowSizeInByte  raw data is read, transposed and written in windows of whole chunks
+   *                          or, for larger chunks, of rows of this size
+   */
+  void deinterleave_tdms_file(const std::string& tdmsFilePath, const std::string& outFilePath, const unsigned threadCount, const bool useIndexFile = true,
+    const uint64_t windowSizeInByte = 64 * 1024 * 1024)
+  {
+    if (0 == windowSizeInByte) {
+      throw std::logic_error("Window size must be at least 1 byte");
+    }
+    const std::filesystem::path fsOutFilePath = std::filesystem::u8path(outFilePath);
+    std::error_code errorCode;
+    if (std::filesystem::equivalent(std::filesystem::u8path(tdmsFilePath), fsOutFilePath, errorCode)) {
+      throw std::logic_error("Converted file must not replace the tdms file");
+    }
+    const TdmsFileLayout layout = read_tdms_file_layout(tdmsFilePath, useIndexFile);
+    FileIo fileIo(tdmsFilePath);
+
+    std::filesystem::path temporaryFilePath = fsOutFilePath;
+    temporaryFilePath += "." + std::to_string(std::random_device()()) + ".tmp";
+    // declared before the stream, so the file is closed before it is removed on errors
+    TemporaryFileGuard temporaryFileGuard(temporaryFilePath);
+    std::ofstream ofs(temporaryFilePath, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!ofs) {
+      throw std::logic_error("Failed to create file");
+    }
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> output;
+    const auto read_input = [&](const uint64_t offset, const uint64_t size) {
+      input.resize(size_t(size));
+      fileIo.seek(offset);
+      fileIo.read_bytes(input.data(), size_t(size));
+    };
+    const auto write_bytes = [&ofs](const uint64_t offset, const uint8_t* bytes, const uint64_t size) {
+      ofs.seekp(std::streamoff(offset));
+      if (!ofs.write(reinterpret_cast<const char*>(bytes), std::streamsize(size))) {
+        throw std::logic_error("Failed to write bytes");
+      }
+    };
+    const auto copy_bytes = [&](uint64_t offset, const uint64_t end) {
+      for (; offset < end; offset += input.size()) {
+        read_input(offset, std::min(windowSizeInByte, end - offset));
+        write_bytes(offset, input.data(), input.size());
+      }
+    };
+
+    const uint64_t fileSize = std::min(fileIo.size(), layout.size_);
+    uint64_t convertedSegments{ 0 };
+    uint64_t position{ 0 };
+    for (const auto& segment : layout.segments_) {
+      if (segment.absolute_offset_ >= fileSize) {
+        break;
+      }
+      const uint64_t rawDataBegin = std::min(segment.raw_data_absolute_offset_, fileSize);
+      const uint64_t rawDataEnd = std::max(rawDataBegin, std::min(segment.raw_data_absolute_end_, fileSize));
+      bool convert = segment.interleaved_ && !segment.daqmx_ && 0 != segment.number_of_chunks_ && !segment.channels_.empty();
+      for (const auto& channel : segment.channels_) {
+        convert = convert && 0 != channel.value_size() && channel.rawInfo_.number_of_values_ == segment.channels_.front().rawInfo_.number_of_values_;
+      }
+      const uint64_t rowsPerChunk = convert ? segment.channels_.front().rawInfo_.number_of_values_ : 0;
+      convert = convert && segment.chunk_size_ == rowsPerChunk * segment.row_size() &&
+        segment.number_of_chunks_ * segment.chunk_size_ <= rawDataEnd - rawDataBegin;
+
+      // lead in and meta data, only the interleaved flag of the table of contents changes
+      copy_bytes(position, segment.absolute_offset_);
+      read_input(segment.absolute_offset_, rawDataBegin - segment.absolute_offset_);
+      if (convert) {
+        input[4] &= uint8_t(~(1U << 5));
+      }
+      write_bytes(segment.absolute_offset_, input.data(), input.size());
+      position = rawDataEnd;
+      if (!convert) {
+        copy_bytes(rawDataBegin, rawDataEnd);
+        continue;
+      }
+
+      const uint64_t rowSize = segment.row_size();
+      const uint64_t chunkSize = segment.chunk_size_;
+      if (chunkSize <= windowSizeInByte) {
+        // whole chunks are transposed in place of the window
+        const uint64_t chunksPerWindow = windowSizeInByte / chunkSize;
+        for (uint64_t chunkIndex = 0; chunkIndex < segment.number_of_chunks_; chunkIndex += chunksPerWindow) {
+          const uint64_t windowChunkCount = std::min(chunksPerWindow, segment.number_of_chunks_ - chunkIndex);
+          const uint64_t windowOffset = rawDataBegin + chunkIndex * chunkSize;
+          read_input(windowOffset, windowChunkCount * chunkSize);
+          output.resize(input.size());
+          transpose_interleaved_rows(segment, input.data(), output.data(), windowChunkCount, rowsPerChunk, threadCount);
+          write_bytes(windowOffset, output.data(), output.size());
+        }
+      }
+      else {
+        // rows of a large chunk are transposed in windows and each channel written to its block
+        const uint64_t rowsPerWindow = std::max<uint64_t>(1, windowSizeInByte / rowSize);
+        for (uint64_t chunkIndex = 0; chunkIndex < segment.number_of_chunks_; ++chunkIndex) {
+          const uint64_t chunkOffset = rawDataBegin + chunkIndex * chunkSize;
+          for (uint64_t firstRow = 0; firstRow < rowsPerChunk; firstRow += rowsPerWindow) {
+            const uint64_t windowRowCount = std::min(rowsPerWindow, rowsPerChunk - firstRow);
+            read_input(chunkOffset + firstRow * rowSize, windowRowCount * rowSize);
+            output.resize(input.size());
+            transpose_interleaved_rows(segment, input.data(), output.data(), 1, windowRowCount, threadCount);
+            for (const auto& channel : segment.channels_) {
+              const uint64_t valueSize = channel.value_size();
+              write_bytes(chunkOffset + rowsPerChunk * channel.offset_in_chunk_ + firstRow * valueSize,
+                output.data() + windowRowCount * channel.offset_in_chunk_, windowRowCount * valueSize);
+            }
+          }
+        }
+      }
+      // values behind the last complete chunk are not part of any channel
+      copy_bytes(rawDataBegin + segment.number_of_chunks_ * chunkSize, rawDataEnd);
+      ++convertedSegments;
+    }
+    copy_bytes(position, fileIo.size());
+    ofs.close();
+    if (!ofs) {
+      throw std::logic_error("Failed to write bytes");
+    }
+    std::filesystem::rename(temporaryFilePath, fsOutFilePath);
+    temporaryFileGuard.keep();
+    std::cout << tdmsFilePath << " -> " << outFilePath << " (" << convertedSegments << " of " << layout.segments_.size()
+      << " segments transposed)" << std::endl;
+  }
+
+  /**
+   * @brief Remove an option from the command line arguments
+   * 
+   * @param args    command line arguments
+   * @param option  option to look for like --as-double
+   * @return true if the option was contained
+   */
+  bool take_option(std::vector<std::string>& args, const std::string& option)
+  {
+    const auto pos = std::find(args.begin(), args.end(), option);
+    if (args.end() == pos) {
+      return false;
+    }
+    args.erase(pos);
+    return true;
+  }
+
+  /**
+   * @brief Remove an option followed by a value from the command line arguments
+   * 
+   * @param args    command line arguments
+   * @param option  option to look for like --range
+   * @param value   receives the argument following the option, empty if missing
+   * @return true if the option was contained
+   */
+  bool take_option_value(std::vector<std::string>& args, const std::string& option, std::string& value)
+  {
+    const auto pos = std::find(args.begin(), args.end(), option);
+    if (args.end() == pos) {
+      return false;
+    }
+    const auto end = args.end() == pos + 1 ? pos + 1 : pos + 2;
+    value = args.end() == pos + 1 ? std::string() : *(pos + 1);
+    args.erase(pos, end);
+    return true;
+  }
+
+  /**
+   * @brief Parse a sample range like 100:200 or 100: into its first and end index
+   */
+  void parse_sample_range(const std::string& range, uint64_t& first, uint64_t& end)
+  {
+    const size_t colon = range.find(':');
+    if (std::string::npos == colon || 0 == colon) {
+      throw std::logic_error("Sample range needs the format FIRST:END");
+    }
+    first = std::stoull(range.substr(0, colon));
+    end = colon + 1 == range.size() ? UINT64_MAX : std::stoull(range.substr(colon + 1));
+  }
+
+}
+
+
+int main(int argc, char const *argv[])
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    const bool extract = take_option(args, "--extract");
+    const bool asDouble = take_option(args, "--as-double");
+    const bool asFloat = take_option(args, "--as-float");
+    const bool asLongDouble = take_option(args, "--as-long-double");
+    const bool asUnixNanoseconds = take_option(args, "--as-unix-ns");
+    const bool asText = take_option(args, "--as-text");
+    const bool asBits = take_option(args, "--as-bits");
+    const bool scaled = take_option(args, "--scaled");
+    std::string range;
+    const bool ranged = take_option_value(args, "--range", range);
+    const bool pyramid = take_option(args, "--pyramid");
+    std::string blockSize;
+    const bool blockSizeGiven = take_option_value(args, "--block-size", blockSize);
+    const bool stats = take_option(args, "--stats");
+    std::string threads;
+    const bool threadsGiven = take_option_value(args, "--threads", threads);
+    const bool hash = take_option(args, "--hash");
+    const bool ignoreIndex = take_option(args, "--ignore-index");
+    const bool writeIndex = take_option(args, "--write-index");
+    const bool batch = take_option(args, "--batch");
+    std::string combinedXmlFilePath;
+    take_option_value(args, "--combined", combinedXmlFilePath);
+    std::string listFilePath;
+    const bool listGiven = take_option_value(args, "--list", listFilePath);
+    const bool catalog = take_option(args, "--catalog");
+    const bool query = take_option(args, "--query");
+    std::string from;
+    const bool fromGiven = take_option_value(args, "--from", from);
+    std::string to;
+    const bool toGiven = take_option_value(args, "--to", to);
+    const bool watch = take_option(args, "--watch");
+    std::string idleExit;
+    const bool idleExitGiven = take_option_value(args, "--idle-exit", idleExit);
+    const bool serve = take_option(args, "--serve");
+    std::string cacheSize;
+    const bool cacheSizeGiven = take_option_value(args, "--cache-size", cacheSize);
+    const bool client = take_option(args, "--client");
+    std::string outputFilePath;
+    take_option_value(args, "--output", outputFilePath);
+    const bool virtualDataset = take_option(args, "--virtual");
+    const bool defragment = take_option(args, "--defragment");
+    const bool deinterleave = take_option(args, "--deinterleave");
+    std::string segmentSize;
+    const bool segmentSizeGiven = take_option_value(args, "--segment-size", segmentSize);
+    std::string windowSize;
+    const bool windowSizeGiven = take_option_value(args, "--window-size", windowSize);
+
+    if((args.empty() && !(batch && listGiven)) || ((extract || pyramid || stats || defragment || deinterleave) && args.size() < 2)) {
+      std::cout << "USAGE: tdms_dump_structure [--ignore-index] TDMSFILEPATH [XMLFILEPATH]" << std::endl;
+      std::cout << "       tdms_dump_structure --extract [--as-double|--as-float|--as-long-double|--as-unix-ns|--as-text|--as-bits|--scaled] [--range FIRST:[END]] TDMSFILEPATH OUTDIR [CHANNELPATH ...]" << std::endl;
+      std::cout << "       tdms_dump_structure --pyramid [--block-size N] TDMSFILEPATH PYRAMIDFILEPATH [CHANNELPATH ...]" << std::endl;
+      std::cout << "       tdms_dump_structure --stats [--threads N] TDMSFILEPATH XMLFILEPATH [CHANNELPATH ...]" << std::endl;
+      std::cout << "       tdms_dump_structure --hash [--threads N] TDMSFILEPATH [XMLFILEPATH]" << std::endl;
+      std::cout << "       tdms_dump_structure --write-index TDMSFILEPATH [INDEXFILEPATH]" << std::endl;
+      std::cout << "       tdms_dump_structure --batch [--threads N] [--hash] [--ignore-index] [--combined XMLFILEPATH] [--list LISTFILEPATH] [TDMSFILEPATH|DIRECTORY ...]" << std::endl;
+      std::cout << "       tdms_dump_structure --catalog [--threads N] [--list LISTFILEPATH] CATALOGFILEPATH [TDMSFILEPATH|DIRECTORY ...]" << std::endl;
+      std::cout << "       tdms_dump_structure --query [--from UNIXSECONDS] [--to UNIXSECONDS] CATALOGFILEPATH [NAME=VALUE ...]" << std::endl;
+      std::cout << "       tdms_dump_structure --watch [--threads N] [--idle-exit SECONDS] CATALOGFILEPATH DIRECTORY" << std::endl;
+      std::cout << "       tdms_dump_structure --serve [--threads N] [--cache-size N] SOCKETPATH" << std::endl;
+      std::cout << "       tdms_dump_structure --client [--output BINFILEPATH] SOCKETPATH REQUEST [ARGUMENT ...]" << std::endl;
+      std::cout << "       tdms_dump_structure --virtual [--as-double] [--stats] [--range FIRST:[END]] [--threads N] [--list LISTFILEPATH] OUTDIR|XMLFILEPATH CHANNELPATH [TDMSFILEPATH|DIRECTORY ...]" << std::endl;
+      std::cout << "       tdms_dump_structure --defragment [--segment-size BYTES] TDMSFILEPATH OUTFILEPATH" << std::endl;
+      std::cout << "       tdms_dump_structure --deinterleave [--threads N] [--window-size BYTES] TDMSFILEPATH OUTFILEPATH" << std::endl;
+      return -1;
+    }
+
+    if (defragment) {
+      try {
+        const uint64_t segmentSizeInByte = segmentSizeGiven ? std::stoull(segmentSize) : 256 * 1024 * 1024;
+        defragment_tdms_file(args[0], args[1], segmentSizeInByte, !ignoreIndex);
+      }
+      catch(const std::exception& ex) {
+        std::cerr << "EXCEPTION: " << ex.what() << std::endl;
+        return -2;
+      }
+      return 0;
+    }
+
+    if (deinterleave) {
+      try {
+        const unsigned threadCount = threadsGiven ? unsigned(std::stoul(threads)) : std::max(1U, std::thread::hardware_concurrency());
+        const uint64_t windowSizeInByte = windowSizeGiven ? std::stoull(windowSize) : 64 * 1024 * 1024;
+        deinterleave_tdms_file(args[0], args[1], threadCount, !ignoreIndex, windowSizeInByte);
+      }
+      catch(const std::exception& ex) {
+        std::cerr << "EXCEPTION: " << ex.what() << std::endl;
+        return -2;
+      }
+      return 0;
+    }
+
+    if (virtualDataset) {
+      try {
+        if (asFloat || asLongDouble || asUnixNanoseconds || asText || asBits || scaled) {
+          throw std::logic_error("Virtual datasets support raw values and --as-double");
+        }
+        if (args.size() < 2) {
+          throw std::logic_error("Output path and channel path are needed");
+        }
+        const unsigned threadCount = threadsGiven ? unsigned(std::stoul(threads)) : std::max(1U, std::thread::hardware_concurrency());
+        uint64_t rangeFirst{ 0 };
+        uint64_t rangeEnd{ UINT64_MAX };
+        if (ranged) {
+          parse_sample_range(range, rangeFirst, rangeEnd);
+        }
+        const std::vector<std::string> tdmsFilePaths = collect_tdms_file_paths(std::vector<std::string>(args.begin() + 2, args.end()), listFilePath);
+        extract_virtual_channel(tdmsFilePaths, args[0], args[1], asDouble, stats, rangeFirst, rangeEnd, threadCount, !ignoreIndex);
+      }
+      catch(const std::exception& ex) {
+        std::cerr << "EXCEPTION: " << ex.what() << std::endl;
+        return -2;
+      }
+      return 0;
+    }
+
+    if (serve || client) {
+#if defined(TDMS_SOCKET)
+      try {
+        if (serve) {
+          const unsigned threadCount = threadsGiven ? unsigned(std::stoul(threads)) : std::max(1U, std::thread::hardware_concurrency());
+          TdmsStructureServer server(args[0], threadCount, cacheSizeGiven ? size_t(std::stoul(cacheSize)) : 256, !ignoreIndex);
+          server.run();
+        }
+        else {
+          if (args.size() < 2) {
+            throw std::logic_error("Socket path and request are needed");
+          }
+          request_tdms_structure_server(args[0], std::vector<std::string>(args.begin() + 1, args.end()), outputFilePath);
+        }
+      }
+      catch(const std::exception& ex) {
+        std::cerr << "EXCEPTION: " << ex.what() << std::endl;
+        return -2;
+      }
+      return 0;
+#else
+      std::cerr << "EXCEPTION: --serve and --client need unix domain sockets" << std::endl;
+      return -2;
+#endif
+    }
+
+    if (watch) {
+#if defined(TDMS_INOTIFY)
+      try {
+        if (args.size() < 2) {
+          throw std::logic_error("Catalog file and directory are needed");
+        }
+        const unsigned threadCount = threadsGiven ? unsigned(std::stoul(threads)) : std::max(1U, std::thread::hardware_concurrency());
+        TdmsDirectoryWatcher watcher(args[1], args[0], threadCount, !ignoreIndex);
+        watcher.run(idleExitGiven ? unsigned(std::stoul(idleExit)) : 0U);
+      }
+      catch(const std::exception& ex) {
+        std::cerr << "EXCEPTION: " << ex.what() << std::endl;
+        return -2;
+      }
+      return 0;
+#else
+      std::cerr << "EXCEPTION: --watch needs inotify and is only available on linux" << std::endl;
+      return -2;
+#endif
+    }
+
+    if (catalog) {
+      try {
+        const unsigned threadCount = threadsGiven ? unsigned(std::stoul(threads)) : std::max(1U, std::thread::hardware_concurrency());
+        const std::vector<std::string> tdmsFilePaths = collect_tdms_file_paths(std::vector<std::string>(args.begin() + 1, args.end()), listFilePath);
+        if (0 != write_tdms_catalog(args[0], tdmsFilePaths, threadCount, !ignoreIndex)) {
+          return -2;
+        }
+      }
+      catch(const std::exception& ex) {
+        std::cerr << "EXCEPTION: " << ex.what() << std::endl;
+        return -2;
+      }
+      return 0;
+    }
+
+    if (query) {
+      try {
+        query_tdms_catalog(args[0], std::vector<std::string>(args.begin() + 1, args.end()),
+          fromGiven ? std::stod(from) : -std::numeric_limits<double>::infinity(), toGiven ? std::stod(to) : std::numeric_limits<double>::infinity());
+      }
+      catch(const std::exception& ex) {
+        std::cerr << "EXCEPTION: " << ex.what() << std::endl;
+        return -2;
+      }
+      return 0;
+    }
+
+    if (batch) {
+      try {
+        const unsigned threadCount = threadsGiven ? unsigned(std::stoul(threads)) : std::max(1U, std::thread::hardware_concurrency());
+        const std::vector<std::string> tdmsFilePaths = collect_tdms_file_paths(args, listFilePath);
+        if (0 != dump_tdms_file_structures(tdmsFilePaths, combinedXmlFilePath, threadCount, hash, !ignoreIndex)) {
+          return -2;
+        }
+      }
+      catch(const std::exception& ex) {
+        std::cerr << "EXCEPTION: " << ex.what() << std::endl;
+        return -2;
+      }
+      return 0;
+    }
+
+    if (writeIndex) {
+      try {
+        write_tdms_index_file(args[0], args.size() > 1 ? args[1] : std::string());
+      }
+      catch(const std::exception& ex) {
+        std::cerr << "EXCEPTION: " << ex.what() << std::endl;
+        return -2;
+      }
+      return 0;
+    }
+
+    if (stats) {
+      try {
+        const unsigned threadCount = threadsGiven ? unsigned(std::stoul(threads)) : std::max(1U, std::thread::hardware_concurrency());
+        write_channel_statistics(args[0], args[1], std::vector<std::string>(args.begin() + 2, args.end()), threadCount, !ignoreIndex);
+      }
+      catch(const std::exception& ex) {
+        std::cerr << "EXCEPTION: " << ex.what() << std::endl;
+        return -2;
+      }
+      return 0;
+    }
+
+    if (pyramid) {
+      try {
+        const uint64_t baseBlockSize = blockSizeGiven ? std::stoull(blockSize) : 1024;
+        build_min_max_pyramids(args[0], args[1], std::vector<std::string>(args.begin() + 2, args.end()), baseBlockSize, !ignoreIndex);
+      }
+      catch(const std::exception& ex) {
+        std::cerr << "EXCEPTION: " << ex.what() << std::endl;
+        return -2;
+      }
+      return 0;
+    }
+
+    if (extract) {
+      try {
+        ExtractionFormat format = extractionFormatRaw;
+        if (asDouble) {
+          format = extractionFormatDouble;
+        }
+        else if (asFloat) {
+          format = extractionFormatFloat;
+        }
+        else if (asLongDouble) {
+          format = extractionFormatLongDouble;
+        }
+        else if (asUnixNanoseconds) {
+          format = extractionFormatUnixNanoseconds;
+        }
+        else if (asText) {
+          format = extractionFormatText;
+        }
+        else if (asBits) {
+          format = extractionFormatBits;
+        }
+        else if (scaled) {
+          format = extractionFormatScaled;
+        }
+        uint64_t rangeFirst{ 0 };
+        uint64_t rangeEnd{ UINT64_MAX };
+        if (ranged) {
+          parse_sample_range(range, rangeFirst, rangeEnd);
+        }
+        extract_tdms_channels(args[0], args[1], std::vector<std::string>(args.begin() + 2, args.end()), format, rangeFirst, rangeEnd, !ignoreIndex);
+      }
+      catch(const std::exception& ex) {
+        std::cerr << "EXCEPTION: " << ex.what() << std::endl;
+        return -2;
+      }
+      return 0;
+    }
+    
+    std::string tdmsFilePath = args[0];
+    std::string xmlResultFilePath = args.size() > 1 ? args[1] : tdmsFilePath + ".structure.xml";
+    try {
+      if (hash) {
+        const unsigned threadCount = threadsGiven ? unsigned(std::stoul(threads)) : std::max(1U, std::thread::hardware_concurrency());
+        write_tdms_file_hashes(tdmsFilePath, xmlResultFilePath, threadCount, !ignoreIndex);
+        return 0;
+      }
       ContentLoggerXml structLog(xmlResultFilePath);
-      log_tdms_file_structure<std::string>(tdmsFilePath, structLog);
+      log_tdms_file_structure<std::string>(tdmsFilePath, structLog, nullptr, nullptr, !ignoreIndex);
     }
     catch(const std::exception& ex) {
       std::cerr << "EXCEPTION: " << ex.what() << std::endl;